@@ -0,0 +1,134 @@
+#include "acpi.hpp"
+
+namespace Kernel::ACPI {
+
+    struct RSDP {
+        char signature[8];
+        u8 checksum;
+        char oemId[6];
+        u8 revision;
+        u32 rsdtAddress;
+    } __attribute__((packed));
+
+    struct MADT {
+        SDTHeader header;
+        u32 localAPICAddress;
+        u32 flags;
+    } __attribute__((packed));
+
+    struct MADTEntryHeader {
+        u8 type;
+        u8 length;
+    } __attribute__((packed));
+
+    struct MADTLocalAPIC {
+        MADTEntryHeader header;
+        u8 processorId;
+        u8 apicId;
+        u32 flags;
+    } __attribute__((packed));
+
+    enum MADTEntryType : u8 {
+        MADT_ENTRY_LOCAL_APIC = 0,
+    };
+
+    // ONLINE_CAPABLE without ENABLED is an empty hot-plug slot, there is no processor to start there
+    constexpr u32 MADT_LOCAL_APIC_ENABLED        = 1 << 0;
+    constexpr u32 MADT_LOCAL_APIC_ONLINE_CAPABLE = 1 << 1;
+
+    constexpr uintptr_t EBDA_SEGMENT_POINTER = 0x40E;
+    constexpr size_t EBDA_SEARCH_SIZE = 1024;
+    constexpr uintptr_t BIOS_AREA_START = 0xE0000;
+    constexpr uintptr_t BIOS_AREA_END = 0x100000;
+    constexpr size_t RSDP_ALIGNMENT = 16;
+
+    static const RSDP* s_rsdp = nullptr;
+
+    bool is_checksum_valid(const void* t_data, size_t t_length) {
+        const u8* bytes = static_cast<const u8*>(t_data);
+
+        u8 sum = 0;
+        for (size_t i = 0; i < t_length; i++) {
+            sum += bytes[i];
+        }
+        return sum == 0;
+    }
+
+    const RSDP* search_rsdp(uintptr_t t_start, uintptr_t t_end) {
+        for (uintptr_t address = t_start; address < t_end; address += RSDP_ALIGNMENT) {
+            const RSDP* rsdp = reinterpret_cast<const RSDP*>(address);
+            if (memcmp(rsdp->signature, "RSD PTR ", sizeof(rsdp->signature)) == 0 && is_checksum_valid(rsdp, sizeof(RSDP))) {
+                return rsdp;
+            }
+        }
+        return nullptr;
+    }
+
+    Data::ErrorOr<const RSDP*> find_rsdp() {
+        if (s_rsdp != nullptr) {
+            return s_rsdp;
+        }
+
+        const uintptr_t ebda = static_cast<uintptr_t>(*reinterpret_cast<const u16*>(EBDA_SEGMENT_POINTER)) << 4;
+        if (ebda != 0) {
+            s_rsdp = search_rsdp(ebda, ebda + EBDA_SEARCH_SIZE);
+        }
+        if (s_rsdp == nullptr) {
+            s_rsdp = search_rsdp(BIOS_AREA_START, BIOS_AREA_END);
+        }
+
+        ASSERT(s_rsdp != nullptr, Error::ACPI_TABLE_NOT_FOUND);
+        return s_rsdp;
+    }
+
+    Data::ErrorOr<const SDTHeader*> find_table(const char* t_signature) {
+        const RSDP* rsdp = TRY(find_rsdp());
+
+        const SDTHeader* rsdt = reinterpret_cast<const SDTHeader*>(rsdp->rsdtAddress);
+        ASSERT(memcmp(rsdt->signature, "RSDT", 4) == 0, Error::ACPI_TABLE_NOT_FOUND);
+        ASSERT(is_checksum_valid(rsdt, rsdt->length), Error::ACPI_INVALID_CHECKSUM);
+
+        const u32* entries = reinterpret_cast<const u32*>(rsdt + 1);
+        const size_t entryCount = (rsdt->length - sizeof(SDTHeader)) / sizeof(u32);
+
+        for (size_t i = 0; i < entryCount; i++) {
+            const SDTHeader* table = reinterpret_cast<const SDTHeader*>(entries[i]);
+            if (memcmp(table->signature, t_signature, 4) != 0) {
+                continue;
+            }
+
+            ASSERT(is_checksum_valid(table, table->length), Error::ACPI_INVALID_CHECKSUM);
+            return table;
+        }
+
+        return Error::ACPI_TABLE_NOT_FOUND;
+    }
+
+    Data::ErrorOr<ProcessorInfo> get_processor_info() {
+        const MADT* madt = reinterpret_cast<const MADT*>(TRY(find_table("APIC")));
+
+        ProcessorInfo info;
+        info.localAPICAddress = madt->localAPICAddress;
+        info.processorCount = 0;
+
+        const u8* entry = reinterpret_cast<const u8*>(madt + 1);
+        const u8* end = reinterpret_cast<const u8*>(madt) + madt->header.length;
+
+        while (entry + sizeof(MADTEntryHeader) <= end) {
+            const MADTEntryHeader* header = reinterpret_cast<const MADTEntryHeader*>(entry);
+            ASSERT(header->length >= sizeof(MADTEntryHeader), Error::ACPI_INVALID_CHECKSUM); // a zero length would loop forever
+
+            if (header->type == MADT_ENTRY_LOCAL_APIC && info.processorCount < MAX_PROCESSOR_COUNT) {
+                const MADTLocalAPIC* localAPIC = reinterpret_cast<const MADTLocalAPIC*>(entry);
+                if ((localAPIC->flags & MADT_LOCAL_APIC_ENABLED) != 0) {
+                    info.apicIds[info.processorCount++] = localAPIC->apicId;
+                }
+            }
+
+            entry += header->length;
+        }
+
+        return info;
+    }
+
+}
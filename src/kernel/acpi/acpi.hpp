@@ -0,0 +1,37 @@
+#ifndef ACPI_INCLUDED
+#define ACPI_INCLUDED
+
+#include "common.hpp"
+#include "data/error_or.hpp"
+
+namespace Kernel::ACPI {
+
+    struct SDTHeader {
+        char signature[4];
+        u32 length; // including the header
+        u8 revision;
+        u8 checksum;
+        char oemId[6];
+        char oemTableId[8];
+        u32 oemRevision;
+        u32 creatorId;
+        u32 creatorRevision;
+    } __attribute__((packed));
+
+    constexpr size_t MAX_PROCESSOR_COUNT = 16;
+
+    struct ProcessorInfo {
+        u32 localAPICAddress;
+        size_t processorCount;
+        u8 apicIds[MAX_PROCESSOR_COUNT]; // enabled processors only, in MADT order
+    };
+
+    // Finds the RSDP in the BIOS area and returns the table with the given 4 character signature from the RSDT
+    Data::ErrorOr<const SDTHeader*> find_table(const char* t_signature);
+
+    // Reads the processor local APIC entries of the MADT
+    Data::ErrorOr<ProcessorInfo> get_processor_info();
+
+}
+
+#endif
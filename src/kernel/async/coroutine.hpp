@@ -0,0 +1,116 @@
+#ifndef ASYNC_COROUTINE_INCLUDED
+#define ASYNC_COROUTINE_INCLUDED
+
+#include <stddef.h>
+
+// The cross compiler has no libstdc++, so this provides the parts of <coroutine> the compiler
+// looks up by name. The layout follows GCC's builtins and libstdc++'s implementation.
+
+namespace std {
+
+    template <typename Ret, typename... Args>
+    struct coroutine_traits {
+        using promise_type = typename Ret::promise_type;
+    };
+
+    template <typename Promise = void>
+    struct coroutine_handle;
+
+    template <>
+    struct coroutine_handle<void> {
+    public:
+        constexpr coroutine_handle() noexcept : m_frame(nullptr) {
+            ;
+        }
+
+        constexpr coroutine_handle(decltype(nullptr)) noexcept : m_frame(nullptr) {
+            ;
+        }
+
+        static constexpr coroutine_handle from_address(void* t_address) noexcept {
+            coroutine_handle handle;
+            handle.m_frame = t_address;
+            return handle;
+        }
+
+        constexpr void* address() const noexcept {
+            return m_frame;
+        }
+
+        constexpr explicit operator bool() const noexcept {
+            return m_frame != nullptr;
+        }
+
+        bool done() const noexcept {
+            return __builtin_coro_done(m_frame);
+        }
+
+        void operator()() const {
+            resume();
+        }
+
+        void resume() const {
+            __builtin_coro_resume(m_frame);
+        }
+
+        void destroy() const {
+            __builtin_coro_destroy(m_frame);
+        }
+
+    protected:
+        void* m_frame;
+    };
+
+    template <typename Promise>
+    struct coroutine_handle : public coroutine_handle<void> {
+    public:
+        constexpr coroutine_handle() noexcept = default;
+
+        static coroutine_handle from_promise(Promise& t_promise) noexcept {
+            coroutine_handle handle;
+            handle.m_frame = __builtin_coro_promise(reinterpret_cast<char*>(&t_promise), __alignof(Promise), true);
+            return handle;
+        }
+
+        static constexpr coroutine_handle from_address(void* t_address) noexcept {
+            coroutine_handle handle;
+            handle.m_frame = t_address;
+            return handle;
+        }
+
+        Promise& promise() const {
+            return *static_cast<Promise*>(__builtin_coro_promise(m_frame, __alignof(Promise), false));
+        }
+    };
+
+    // Resuming or destroying this frame does nothing, it is what a finished coroutine with no continuation transfers to
+    struct noop_coroutine_frame {
+        void (*resume)(void*);
+        void (*destroy)(void*);
+    };
+
+    inline void noop_coroutine_resume_destroy(void*) {
+        ;
+    }
+
+    inline noop_coroutine_frame noop_coroutine_static_frame = { noop_coroutine_resume_destroy, noop_coroutine_resume_destroy };
+
+    inline coroutine_handle<> noop_coroutine() noexcept {
+        return coroutine_handle<>::from_address(&noop_coroutine_static_frame);
+    }
+
+    struct suspend_always {
+        constexpr bool await_ready() const noexcept { return false; }
+        constexpr void await_suspend(coroutine_handle<>) const noexcept {}
+        constexpr void await_resume() const noexcept {}
+    };
+
+    struct suspend_never {
+        constexpr bool await_ready() const noexcept { return true; }
+        constexpr void await_suspend(coroutine_handle<>) const noexcept {}
+        constexpr void await_resume() const noexcept {}
+    };
+
+}
+
+#endif
@@ -0,0 +1,65 @@
+#include "event.hpp"
+
+namespace Kernel::Async {
+
+    void Event::reset() {
+        m_set = false;
+    }
+
+    void Event::signal() {
+        const u32 flags = save_and_disable_interrupts();
+
+        m_set = true;
+        while (m_waiters != nullptr) {
+            WaitAwaiter* waiter = m_waiters;
+            m_waiters = waiter->m_next;
+
+            cancel_timer(waiter->m_timer);
+            schedule(waiter->m_handle);
+        }
+
+        restore_interrupts(flags);
+    }
+
+    void Event::remove_waiter(WaitAwaiter* t_waiter) {
+        for (WaitAwaiter** link = &m_waiters; *link != nullptr; link = &(*link)->m_next) {
+            if (*link == t_waiter) {
+                *link = t_waiter->m_next;
+                return;
+            }
+        }
+    }
+
+    bool Event::WaitAwaiter::await_suspend(std::coroutine_handle<> t_handle) {
+        const u32 flags = save_and_disable_interrupts();
+
+        // The IRQ may have fired between await_ready and here
+        if (m_event.is_set()) {
+            restore_interrupts(flags);
+            return false;
+        }
+
+        m_handle = t_handle;
+        m_next = m_event.m_waiters;
+        m_event.m_waiters = this;
+
+        if (m_timeoutTicks != 0) {
+            m_timer.callback = on_timeout;
+            m_timer.context = this;
+            add_timer(m_timer, m_timeoutTicks);
+        }
+
+        restore_interrupts(flags);
+
+        return true;
+    }
+
+    void Event::WaitAwaiter::on_timeout(void* t_context) {
+        WaitAwaiter* waiter = static_cast<WaitAwaiter*>(t_context);
+
+        waiter->m_event.remove_waiter(waiter);
+        waiter->m_timedOut = true;
+        schedule(waiter->m_handle);
+    }
+
+}
@@ -0,0 +1,82 @@
+#ifndef ASYNC_EVENT_INCLUDED
+#define ASYNC_EVENT_INCLUDED
+
+#include "common.hpp"
+#include "async/coroutine.hpp"
+#include "async/executor.hpp"
+#include "data/error_or.hpp"
+
+namespace Kernel::Async {
+
+    // Awaitable counterpart of Sync::Completion, typically signalled by an IRQ handler. Once set it
+    // stays set until reset, so a signal that arrives before the coroutine awaits is not lost.
+    class Event {
+    public:
+        class WaitAwaiter {
+        public:
+            WaitAwaiter(Event& t_event, uint t_timeoutTicks)
+                : m_event(t_event)
+                , m_timeoutTicks(t_timeoutTicks)
+            {
+                ;
+            }
+
+            bool await_ready() const {
+                return m_event.is_set();
+            }
+
+            bool await_suspend(std::coroutine_handle<> t_handle);
+
+            Data::ErrorOr<void> await_resume() const {
+                if (m_timedOut) {
+                    return Error::TIMED_OUT;
+                }
+                return Data::ErrorOr<void>();
+            }
+
+        private:
+            friend class Event;
+
+            static void on_timeout(void* t_context);
+
+            Event& m_event;
+            uint m_timeoutTicks;
+
+            std::coroutine_handle<> m_handle;
+            Timer m_timer;
+            WaitAwaiter* m_next = nullptr;
+            bool m_timedOut = false;
+        };
+
+        constexpr Event()
+            : m_set(false)
+            , m_waiters(nullptr)
+        {
+            ;
+        }
+
+        // Re-arms the event, call before starting the operation that will signal it
+        void reset();
+
+        // Safe to call from interrupt handlers, schedules every waiting coroutine
+        void signal();
+
+        [[nodiscard]] bool is_set() const {
+            return m_set;
+        }
+
+        // co_await event.wait(t) gives an ErrorOr<void>, TIMED_OUT if t ticks pass first (0 waits forever)
+        WaitAwaiter wait(uint t_timeoutTicks = 0) {
+            return WaitAwaiter(*this, t_timeoutTicks);
+        }
+
+    private:
+        void remove_waiter(WaitAwaiter* t_waiter);
+
+        volatile bool m_set;
+        WaitAwaiter* m_waiters;
+    };
+
+}
+
+#endif
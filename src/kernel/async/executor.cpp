@@ -0,0 +1,147 @@
+#include "executor.hpp"
+#include "data/spsc_ring.hpp"
+#include "drivers/pit/pit.hpp"
+#include "drivers/vga/vga.hpp"
+#include "interrupts/irq.hpp"
+#include "sync/semaphore.hpp"
+
+namespace Kernel::Async {
+
+    // Tick counts wrap, so compare them by their difference
+    static bool tick_before(uint t_a, uint t_b) {
+        return static_cast<int>(t_a - t_b) < 0;
+    }
+
+    struct WakeOrder {
+        static bool less(const Timer& t_a, const Timer& t_b) {
+            return tick_before(t_a.wakeTick, t_b.wakeTick);
+        }
+    };
+
+    static struct {
+        Data::SPSCRing<void*, READY_QUEUE_SIZE> readyQueue; // coroutine frame addresses, run_pending is the only consumer
+        Sync::Semaphore readyCount;
+        Data::RBTree<Timer, &Timer::node, WakeOrder> timers;
+        Scheduler::Thread* thread;
+    } s_executorState;
+
+    void executor_thread_main(void* t_argument);
+    void timer_tick(void* t_context);
+
+    Data::ErrorOr<void> initialize() {
+        ASSERT(!is_initialized(), Error::INVALID_ARGUMENT);
+
+        TRY(IRQ::register_handler(IRQ::LINE_TIMER, timer_tick, nullptr));
+        s_executorState.thread = TRY(Scheduler::create_thread("async", executor_thread_main, nullptr));
+
+        return Data::ErrorOr<void>();
+    }
+
+    bool is_initialized() {
+        return s_executorState.thread != nullptr;
+    }
+
+    void schedule(std::coroutine_handle<> t_handle) {
+        // Threads and interrupt handlers both schedule, keep them from pushing at the same time
+        const u32 flags = save_and_disable_interrupts();
+        const auto result = s_executorState.readyQueue.push(t_handle.address());
+        restore_interrupts(flags);
+
+        // Dropping a handle would leave its coroutine (and whoever awaits it) suspended forever
+        if (result.is_error()) {
+            VGA::put_string("Async ready queue is full\n");
+            KERNEL_STOP();
+        }
+
+        s_executorState.readyCount.signal();
+    }
+
+    void run_pending() {
+        while (true) {
+            const auto item = s_executorState.readyQueue.pop();
+            if (item.is_error()) {
+                return;
+            }
+
+            // Keep the count in step with the queue when draining from outside the executor thread
+            (void)s_executorState.readyCount.try_wait();
+
+            std::coroutine_handle<>::from_address(item.get_value()).resume();
+        }
+    }
+
+    void add_timer(Timer& t_timer, uint t_ticks) {
+        const u32 flags = save_and_disable_interrupts();
+
+        if (t_timer.armed) {
+            cancel_timer(t_timer);
+        }
+
+        t_timer.wakeTick = PIT::get_ticks() + t_ticks;
+        t_timer.armed = true;
+        s_executorState.timers.insert(t_timer);
+
+        restore_interrupts(flags);
+    }
+
+    bool cancel_timer(Timer& t_timer) {
+        const u32 flags = save_and_disable_interrupts();
+
+        const bool found = t_timer.armed;
+        if (found) {
+            s_executorState.timers.remove(t_timer);
+        }
+        t_timer.armed = false;
+
+        restore_interrupts(flags);
+
+        return found;
+    }
+
+    void SleepAwaiter::await_suspend(std::coroutine_handle<> t_handle) {
+        m_timer.callback = [](void* t_context) {
+            schedule(std::coroutine_handle<>::from_address(t_context));
+        };
+        m_timer.context = t_handle.address();
+
+        add_timer(m_timer, m_ticks);
+    }
+
+    static DetachedTask run_detached(Task<void> t_task) {
+        const auto result = co_await t_task;
+        if (result.is_error()) {
+            VGA::put_string("Async task failed with error: ");
+            VGA::put_string(get_error_string(result.get_error()));
+            VGA::new_line();
+        }
+    }
+
+    void spawn(Task<void>&& t_task) {
+        run_detached(static_cast<Task<void>&&>(t_task));
+    }
+
+    bool Detail::must_drive_inline() {
+        return !is_initialized() || Scheduler::get_current_thread() == s_executorState.thread;
+    }
+
+    void executor_thread_main(void* t_argument) {
+        (void)t_argument;
+
+        while (true) {
+            (void)s_executorState.readyCount.wait();
+            run_pending();
+        }
+    }
+
+    void timer_tick(void* t_context) {
+        (void)t_context;
+
+        const uint now = PIT::get_ticks();
+        for (Timer* timer = s_executorState.timers.first(); timer != nullptr && !tick_before(now, timer->wakeTick); timer = s_executorState.timers.first()) {
+            s_executorState.timers.remove(*timer);
+            timer->armed = false;
+            timer->callback(timer->context);
+        }
+    }
+
+}
@@ -0,0 +1,120 @@
+#ifndef ASYNC_EXECUTOR_INCLUDED
+#define ASYNC_EXECUTOR_INCLUDED
+
+#include "common.hpp"
+#include "async/coroutine.hpp"
+#include "async/task.hpp"
+#include "data/error_or.hpp"
+#include "data/rb_tree.hpp"
+#include "scheduler/scheduler.hpp"
+#include "sync/completion.hpp"
+
+namespace Kernel::Async {
+
+    // Suspended coroutines are resumed on a single executor thread in the order they became ready
+    constexpr size_t READY_QUEUE_SIZE = 64; // must be a power of two
+
+    // Called from the timer IRQ with interrupts disabled, so it must only do IRQ-safe work (e.g. schedule)
+    using TimerCallback = void (*)(void* t_context);
+
+    // Intrusive timer, owned by whoever arms it (usually an awaiter living in a coroutine frame)
+    struct Timer {
+        TimerCallback callback = nullptr;
+        void* context = nullptr;
+
+        uint wakeTick = 0;
+        Data::RBTreeNode node;
+        bool armed = false;
+    };
+
+    // Starts the executor thread and its timer tick, needs the scheduler.
+    // Must be called before any Task that awaits an IRQ or a timer is started
+    Data::ErrorOr<void> initialize();
+
+    [[nodiscard]] bool is_initialized();
+
+    // Queues a suspended coroutine to be resumed on the executor thread, safe to call from interrupt handlers
+    void schedule(std::coroutine_handle<> t_handle);
+
+    // Resumes every coroutine that is ready, with interrupts enabled. Only the executor thread (or block_on
+    // before it exists) may call this, the ready queue has a single consumer
+    void run_pending();
+
+    // Calls t_timer's callback once at least t_ticks timer ticks have passed
+    void add_timer(Timer& t_timer, uint t_ticks);
+
+    // Returns false if the timer had already fired (or was never armed)
+    bool cancel_timer(Timer& t_timer);
+
+    class SleepAwaiter {
+    public:
+        explicit SleepAwaiter(uint t_ticks) : m_ticks(t_ticks) {
+            ;
+        }
+
+        bool await_ready() const {
+            return m_ticks == 0;
+        }
+
+        void await_suspend(std::coroutine_handle<> t_handle);
+
+        void await_resume() const {
+            ;
+        }
+
+    private:
+        uint m_ticks;
+        Timer m_timer;
+    };
+
+    // co_await sleep_for(t) suspends the coroutine for at least t timer ticks without blocking a thread
+    inline SleepAwaiter sleep_for(uint t_ticks) {
+        return SleepAwaiter(t_ticks);
+    }
+
+    // Runs t_task to completion in the background, its result is dropped (errors are printed)
+    void spawn(Task<void>&& t_task);
+
+    namespace Detail {
+
+        template <typename T>
+        DetachedTask complete_into(Task<T>& t_task, Data::ErrorOr<T>& r_result, Sync::Completion& t_completion) {
+            r_result = co_await t_task;
+            t_completion.complete();
+        }
+
+        // True when blocking the calling thread would stop the task from ever being resumed
+        [[nodiscard]] bool must_drive_inline();
+
+    }
+
+    // Blocks the calling thread until t_task finishes and returns its result
+    template <typename T>
+    Data::ErrorOr<T> block_on(Task<T>&& t_task) {
+        if (t_task.is_done()) {
+            return t_task.get_result();
+        }
+
+        // Before the executor thread is running (or when called from it) nobody else resumes the task
+        if (Detail::must_drive_inline()) {
+            while (!t_task.is_done()) {
+                run_pending();
+                if (!t_task.is_done()) {
+                    KERNEL_HALT();
+                }
+            }
+            return t_task.get_result();
+        }
+
+        Sync::Completion completion;
+        Data::ErrorOr<T> result = Error::UNINITIALIZED;
+
+        Detail::complete_into(t_task, result, completion);
+        TRY(completion.wait());
+
+        return result;
+    }
+
+}
+
+#endif
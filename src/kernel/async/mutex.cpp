@@ -0,0 +1,62 @@
+#include "mutex.hpp"
+#include "executor.hpp"
+
+namespace Kernel::Async {
+
+    bool Mutex::try_lock() {
+        Sync::LockGuard guard(m_lock);
+
+        if (m_locked) {
+            return false;
+        }
+
+        m_locked = true;
+        m_statistics.on_acquire(false);
+        return true;
+    }
+
+    void Mutex::unlock() {
+        Sync::LockGuard guard(m_lock);
+
+        m_statistics.on_release();
+
+        LockAwaiter* waiter = m_head;
+        if (waiter == nullptr) {
+            m_locked = false;
+            return;
+        }
+
+        // Ownership passes directly, m_locked stays set so nobody can barge in before the waiter runs
+        m_head = waiter->m_next;
+        if (m_head == nullptr) {
+            m_tail = nullptr;
+        }
+
+        m_statistics.on_acquire(true);
+        schedule(waiter->m_handle);
+    }
+
+    bool Mutex::LockAwaiter::await_suspend(std::coroutine_handle<> t_handle) {
+        Sync::LockGuard guard(m_mutex.m_lock);
+
+        // Unlocked between await_ready and here
+        if (!m_mutex.m_locked) {
+            m_mutex.m_locked = true;
+            m_mutex.m_statistics.on_acquire(false);
+            return false;
+        }
+
+        m_handle = t_handle;
+        m_next = nullptr;
+        if (m_mutex.m_tail == nullptr) {
+            m_mutex.m_head = this;
+        }
+        else {
+            m_mutex.m_tail->m_next = this;
+        }
+        m_mutex.m_tail = this;
+
+        return true;
+    }
+
+}
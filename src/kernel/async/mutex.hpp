@@ -0,0 +1,98 @@
+#ifndef ASYNC_MUTEX_INCLUDED
+#define ASYNC_MUTEX_INCLUDED
+
+#include "common.hpp"
+#include "async/coroutine.hpp"
+#include "sync/lock_statistics.hpp"
+#include "sync/spinlock.hpp"
+
+namespace Kernel::Async {
+
+    // Lock that coroutines can hold across co_await. Waiters are suspended rather than blocking the executor,
+    // and unlock hands the lock straight to the oldest waiter.
+    //     const auto guard = co_await mutex.lock();
+    class Mutex {
+    public:
+        // Releases the mutex when it goes out of scope
+        class Guard {
+        public:
+            explicit Guard(Mutex* t_mutex) : m_mutex(t_mutex) {
+                ;
+            }
+
+            Guard(Guard&& t_other) : m_mutex(t_other.m_mutex) {
+                t_other.m_mutex = nullptr;
+            }
+
+            Guard(const Guard&) = delete;
+            Guard& operator=(const Guard&) = delete;
+
+            ~Guard() {
+                if (m_mutex != nullptr) {
+                    m_mutex->unlock();
+                }
+            }
+
+        private:
+            Mutex* m_mutex;
+        };
+
+        class LockAwaiter {
+        public:
+            explicit LockAwaiter(Mutex& t_mutex) : m_mutex(t_mutex) {
+                ;
+            }
+
+            bool await_ready() {
+                return m_mutex.try_lock();
+            }
+
+            bool await_suspend(std::coroutine_handle<> t_handle);
+
+            Guard await_resume() {
+                return Guard(&m_mutex);
+            }
+
+        private:
+            friend class Mutex;
+
+            Mutex& m_mutex;
+            std::coroutine_handle<> m_handle;
+            LockAwaiter* m_next = nullptr;
+        };
+
+        constexpr explicit Mutex(const char* t_name = nullptr)
+            : m_lock()
+            , m_locked(false)
+            , m_head(nullptr)
+            , m_tail(nullptr)
+            , m_statistics(t_name)
+        {
+            ;
+        }
+
+        Mutex(const Mutex&) = delete;
+        Mutex& operator=(const Mutex&) = delete;
+
+        [[nodiscard]] LockAwaiter lock() {
+            return LockAwaiter(*this);
+        }
+
+        [[nodiscard]] bool try_lock();
+        void unlock();
+
+        [[nodiscard]] Sync::LockStatistics get_statistics() const {
+            return m_statistics.get();
+        }
+
+    private:
+        Sync::IRQSpinLock m_lock;
+        bool m_locked;
+        LockAwaiter* m_head; // FIFO of suspended waiters
+        LockAwaiter* m_tail;
+        Sync::LockStatisticsRecord m_statistics;
+    };
+
+}
+
+#endif
@@ -0,0 +1,188 @@
+#ifndef ASYNC_TASK_INCLUDED
+#define ASYNC_TASK_INCLUDED
+
+#include "common.hpp"
+#include "async/coroutine.hpp"
+#include "data/error_or.hpp"
+
+namespace Kernel::Async {
+
+    // A coroutine that produces a Data::ErrorOr<T>. Tasks start running as soon as they are called and
+    // only suspend when they await something that isn't ready yet (an IRQ, a timer, ...). Awaiting a
+    // task gives back its ErrorOr, and the awaiting coroutine resumes directly when the task finishes.
+    template <typename T>
+    class Task {
+    public:
+        class promise_type;
+        using Handle = std::coroutine_handle<promise_type>;
+
+        struct FinalAwaiter {
+            bool await_ready() const noexcept {
+                return false;
+            }
+
+            std::coroutine_handle<> await_suspend(Handle t_handle) noexcept {
+                promise_type& promise = t_handle.promise();
+
+                // Pairs with Task::await_suspend, which may be registering a continuation from another thread
+                const u32 flags = save_and_disable_interrupts();
+                promise.m_finished = true;
+                const std::coroutine_handle<> continuation = promise.m_continuation;
+                restore_interrupts(flags);
+
+                return continuation ? continuation : std::noop_coroutine();
+            }
+
+            void await_resume() const noexcept {
+                ;
+            }
+        };
+
+        class promise_type {
+        public:
+            Task get_return_object() {
+                return Task(Handle::from_promise(*this));
+            }
+
+            std::suspend_never initial_suspend() const noexcept {
+                return {};
+            }
+
+            FinalAwaiter final_suspend() const noexcept {
+                return {};
+            }
+
+            void return_value(Data::ErrorOr<T> t_result) {
+                m_result = t_result;
+            }
+
+            void unhandled_exception() {
+                ;
+            }
+
+        private:
+            friend class Task;
+            friend struct FinalAwaiter;
+
+            Data::ErrorOr<T> m_result = Error::UNINITIALIZED;
+            std::coroutine_handle<> m_continuation;
+            volatile bool m_finished = false;
+        };
+
+        Task(const Task&) = delete;
+        Task& operator=(const Task&) = delete;
+
+        Task(Task&& t_other) : m_handle(t_other.m_handle) {
+            t_other.m_handle = Handle();
+        }
+
+        // The task being replaced must have finished
+        Task& operator=(Task&& t_other) {
+            if (this != &t_other) {
+                if (m_handle) {
+                    m_handle.destroy();
+                }
+                m_handle = t_other.m_handle;
+                t_other.m_handle = Handle();
+            }
+            return *this;
+        }
+
+        ~Task() {
+            if (m_handle) {
+                m_handle.destroy();
+            }
+        }
+
+        [[nodiscard]] bool is_done() const {
+            return m_handle.promise().m_finished;
+        }
+
+        // Only valid once is_done() is true
+        [[nodiscard]] Data::ErrorOr<T> get_result() const {
+            return m_handle.promise().m_result;
+        }
+
+        bool await_ready() const {
+            return is_done();
+        }
+
+        bool await_suspend(std::coroutine_handle<> t_continuation) {
+            const u32 flags = save_and_disable_interrupts();
+
+            const bool suspend = !is_done();
+            if (suspend) {
+                m_handle.promise().m_continuation = t_continuation;
+            }
+
+            restore_interrupts(flags);
+
+            return suspend;
+        }
+
+        Data::ErrorOr<T> await_resume() const {
+            return get_result();
+        }
+
+    private:
+        explicit Task(Handle t_handle) : m_handle(t_handle) {
+            ;
+        }
+
+        Handle m_handle;
+    };
+
+    // Coroutine that frees itself when it finishes, used to run a Task that nobody awaits
+    struct DetachedTask {
+        struct promise_type {
+            DetachedTask get_return_object() const {
+                return {};
+            }
+
+            std::suspend_never initial_suspend() const noexcept {
+                return {};
+            }
+
+            std::suspend_never final_suspend() const noexcept {
+                return {};
+            }
+
+            void return_void() const {
+                ;
+            }
+
+            void unhandled_exception() const {
+                ;
+            }
+        };
+    };
+
+}
+
+// TRY and ASSERT for coroutines. GCC can't compile co_await or co_return inside a statement expression,
+// so these are statements and the value form declares its result instead of evaluating to it:
+//     CO_TRY_ASSIGN(const u8 msr, read_msr());
+#define CO_CONCAT_INNER(a, b) a##b
+#define CO_CONCAT(a, b) CO_CONCAT_INNER(a, b)
+
+#define CO_TRY(x) do {\
+    const auto _errorOrX = (x);\
+    if (_errorOrX.is_error()) {\
+        co_return _errorOrX.get_error();\
+    }\
+} while(false)
+
+#define CO_TRY_ASSIGN(declaration, x)\
+    const auto CO_CONCAT(_errorOrX, __LINE__) = (x);\
+    if (CO_CONCAT(_errorOrX, __LINE__).is_error()) {\
+        co_return CO_CONCAT(_errorOrX, __LINE__).get_error();\
+    }\
+    declaration = CO_CONCAT(_errorOrX, __LINE__).get_value()
+
+#define CO_ASSERT(x, e) do {\
+    if (!(x)) {\
+        co_return (e);\
+    }\
+} while(false)
+
+#endif
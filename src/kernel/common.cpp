@@ -1,5 +1,6 @@
 #include "common.hpp"
 #include "drivers/pit/pit.hpp"
+#include "scheduler/scheduler.hpp"
 
 namespace Kernel {
 
@@ -41,7 +42,22 @@ namespace Kernel {
         port_write_byte(0x80, 0);
     }
 
+    u64 read_timestamp_counter() {
+        u32 lo = 0;
+        u32 hi = 0;
+        asm volatile (
+            "rdtsc"
+            : "=a" (lo), "=d" (hi)
+        );
+        return (static_cast<u64>(hi) << 32) | lo;
+    }
+
     void sleep(uint t_ticks) {
+        if (Scheduler::is_initialized()) {
+            Scheduler::sleep(t_ticks);
+            return;
+        }
+
         const uint start = PIT::get_ticks();
 
         while (PIT::get_ticks() - start < t_ticks) {
@@ -50,11 +66,32 @@ namespace Kernel {
     }
 
     void enable_interrupts() {
-        asm volatile ("sti");
+        asm volatile ("sti" : : : "memory");
     }
 
     void disable_interrupts() {
-        asm volatile ("cli");
+        asm volatile ("cli" : : : "memory");
+    }
+
+    u32 save_and_disable_interrupts() {
+        u32 flags = 0;
+        asm volatile (
+            "pushf;"
+            "pop %0;"
+            "cli;"
+            : "=r" (flags)
+            :
+            : "memory"
+        );
+        return flags;
+    }
+
+    void restore_interrupts(u32 t_flags) {
+        constexpr u32 INTERRUPT_FLAG = 0x200;
+
+        if (t_flags & INTERRUPT_FLAG) {
+            enable_interrupts();
+        }
     }
 
     
@@ -106,3 +143,14 @@ int memcmp(const void* t_lhs, const void* t_rhs, size_t t_count) {
     return 0;
 }
 
+// Statics with destructors register them here, the kernel never exits so they are never run
+extern "C" {
+    void* __dso_handle = nullptr;
+
+    int __cxa_atexit(void (*t_destructor)(void*), void* t_argument, void* t_dsoHandle) {
+        (void)t_destructor;
+        (void)t_argument;
+        (void)t_dsoHandle;
+        return 0;
+    }
+}
@@ -27,12 +27,18 @@ namespace Kernel {
 
     void io_wait();
 
+    u64 read_timestamp_counter();
+
     // sleep(1000) sleeps for 1 second
     void sleep(uint t_milliseconds);
 
     void enable_interrupts();
     void disable_interrupts();
 
+    // Disables interrupts and returns the previous EFLAGS so that restore_interrupts can put them back
+    u32 save_and_disable_interrupts();
+    void restore_interrupts(u32 t_flags);
+
     template <typename T>
     constexpr T get_smallest_gte_multiple(T t_value, T t_multiple) {
         if (t_value % t_multiple == 0) {
@@ -0,0 +1,28 @@
+#ifndef DATA_ALLOCATOR_INCLUDED
+#define DATA_ALLOCATOR_INCLUDED
+
+#include "common.hpp"
+#include "data/error_or.hpp"
+#include "memory-manager/magazine.hpp"
+#include "memory-manager/manager.hpp"
+
+namespace Kernel::Data {
+
+    // Containers take their memory from an allocator type with
+    //     static Data::ErrorOr<void*> allocate(size_t t_size);
+    //     static void deallocate(void* t_memory);
+    // so that running out of memory is an error they can hand back instead of a kernel stop
+
+    struct KernelAllocator {
+        static Data::ErrorOr<void*> allocate(size_t t_size) {
+            return Magazine::allocate(t_size);
+        }
+
+        static void deallocate(void* t_memory) {
+            kfree(t_memory);
+        }
+    };
+
+}
+
+#endif
@@ -0,0 +1,71 @@
+#include "benchmark.hpp"
+#include "data/hash_map.hpp"
+#include "drivers/vga/vga.hpp"
+
+namespace Kernel::Data {
+
+    struct KeyValue {
+        u32 key;
+        u32 value;
+    };
+
+    // The baseline that a table without a map ends up with
+    static const u32* linear_find(const KeyValue* t_entries, size_t t_count, u32 t_key) {
+        for (size_t i = 0; i < t_count; i++) {
+            if (t_entries[i].key == t_key) {
+                return &t_entries[i].value;
+            }
+        }
+        return nullptr;
+    }
+
+    void print_hash_map_benchmark() {
+        constexpr size_t MAX_ENTRY_COUNT = 1024;
+        constexpr size_t LOOKUP_COUNT = 4096;
+
+        VGA::put_string("Lookups of 4K keys, half present\n--------------------------------\n");
+
+        KeyValue* entries = new KeyValue[MAX_ENTRY_COUNT];
+
+        for (size_t count = 16; count <= MAX_ENTRY_COUNT; count *= 4) {
+            HashMap<u32, u32> map;
+            if (map.reserve(count).is_error()) {
+                VGA::put_string("Out of memory\n");
+                break;
+            }
+
+            // Even keys are stored, odd ones are the misses
+            for (size_t i = 0; i < count; i++) {
+                entries[i] = KeyValue { hash_integer(i) & ~1u, static_cast<u32>(i) };
+                (void)map.set(entries[i].key, entries[i].value);
+            }
+
+            u32 linearFound = 0;
+            const u64 linearStart = read_timestamp_counter();
+            for (size_t i = 0; i < LOOKUP_COUNT; i++) {
+                const u32 key = entries[i % count].key | (i & 1);
+                linearFound += (linear_find(entries, count, key) != nullptr);
+            }
+            const u64 linearCycles = read_timestamp_counter() - linearStart;
+
+            u32 mapFound = 0;
+            const u64 mapStart = read_timestamp_counter();
+            for (size_t i = 0; i < LOOKUP_COUNT; i++) {
+                const u32 key = entries[i % count].key | (i & 1);
+                mapFound += (map.find(key) != nullptr);
+            }
+            const u64 mapCycles = read_timestamp_counter() - mapStart;
+
+            VGA::put_unsigned_decimal(count);
+            VGA::put_string(" entries: linear ");
+            VGA::put_unsigned_decimal(static_cast<u32>(linearCycles / 1000));
+            VGA::put_string(" kcycles, map ");
+            VGA::put_unsigned_decimal(static_cast<u32>(mapCycles / 1000));
+            VGA::put_string(linearFound == mapFound ? " kcycles\n" : " kcycles, MISMATCH\n");
+        }
+
+        delete[] entries;
+        VGA::new_line();
+    }
+
+}
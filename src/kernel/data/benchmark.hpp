@@ -0,0 +1,11 @@
+#ifndef DATA_BENCHMARK_INCLUDED
+#define DATA_BENCHMARK_INCLUDED
+
+namespace Kernel::Data {
+
+    // Times lookups in a HashMap against a linear scan of an array for growing table sizes
+    void print_hash_map_benchmark();
+
+}
+
+#endif
@@ -0,0 +1,369 @@
+#ifndef DATA_HASH_MAP_INCLUDED
+#define DATA_HASH_MAP_INCLUDED
+
+#include "common.hpp"
+#include "data/allocator.hpp"
+#include "data/error_or.hpp"
+#include "data/utility.hpp"
+
+namespace Kernel::Data {
+
+    // Murmur3's finaliser, spreads every input bit over the whole result
+    constexpr u32 hash_integer(u64 t_value) {
+        u32 hash = static_cast<u32>(t_value) ^ static_cast<u32>(t_value >> 32);
+        hash ^= hash >> 16;
+        hash *= 0x85EBCA6B;
+        hash ^= hash >> 13;
+        hash *= 0xC2B2AE35;
+        hash ^= hash >> 16;
+        return hash;
+    }
+
+    // FNV-1a over a NUL terminated string
+    constexpr u32 hash_string(const char* t_string) {
+        u32 hash = 0x811C9DC5;
+        for (; *t_string != '\0'; t_string++) {
+            hash = (hash ^ static_cast<u8>(*t_string)) * 0x01000193;
+        }
+        return hash;
+    }
+
+    // Tells a HashMap how to hash and compare keys. Both are templates so a map can be searched with any type
+    // they accept (heterogeneous lookup), e.g. a map keyed by u64 can be searched with a u32 without converting.
+    // The default works for integers, enums and pointers
+    template <typename K>
+    struct HashTraits {
+        template <typename Q>
+        static constexpr u32 hash(const Q& t_key) {
+            return hash_integer(static_cast<u64>(t_key));
+        }
+
+        template <typename Q>
+        static constexpr bool equals(const K& t_key, const Q& t_other) {
+            return t_key == t_other;
+        }
+    };
+
+    template <typename T>
+    struct HashTraits<T*> {
+        static u32 hash(const T* t_key) {
+            return hash_integer(reinterpret_cast<uintptr_t>(t_key));
+        }
+
+        static bool equals(const T* t_key, const T* t_other) {
+            return t_key == t_other;
+        }
+    };
+
+    // For const char* keys that should be compared by their contents rather than their address
+    struct StringHashTraits {
+        static constexpr u32 hash(const char* t_key) {
+            return hash_string(t_key);
+        }
+
+        static constexpr bool equals(const char* t_key, const char* t_other) {
+            while (*t_key != '\0' && *t_key == *t_other) {
+                t_key++;
+                t_other++;
+            }
+            return *t_key == *t_other;
+        }
+    };
+
+    // Open addressing hash map with Robin Hood probing: an entry being inserted takes the slot of any entry that is
+    // closer to its home slot, which keeps every probe sequence short even at high load. Removal shifts the following
+    // entries back instead of leaving tombstones. Probe distances live in their own array, so a lookup mostly walks
+    // over a few bytes and only touches the entry it is after.
+    // Pointers to values are invalidated by set and remove
+    template <typename K, typename V, typename Traits = HashTraits<K>, typename Allocator = KernelAllocator>
+    class HashMap {
+    public:
+        struct Entry {
+            K key;
+            V value;
+        };
+
+        class Iterator {
+        public:
+            Iterator(HashMap& t_map, size_t t_index)
+                : m_map(t_map)
+                , m_index(t_index)
+            {
+                skip_empty();
+            }
+
+            Entry& operator*() const {
+                return m_map.m_entries[m_index];
+            }
+
+            Entry* operator->() const {
+                return &m_map.m_entries[m_index];
+            }
+
+            Iterator& operator++() {
+                m_index++;
+                skip_empty();
+                return *this;
+            }
+
+            bool operator!=(const Iterator& t_other) const {
+                return m_index != t_other.m_index;
+            }
+
+        private:
+            void skip_empty() {
+                while (m_index < m_map.m_capacity && m_map.m_distances[m_index] == 0) {
+                    m_index++;
+                }
+            }
+
+            HashMap& m_map;
+            size_t m_index;
+        };
+
+        // Keeps every probe distance below 2^16
+        static constexpr size_t MAX_CAPACITY = 32768;
+
+        HashMap()
+            : m_distances(nullptr)
+            , m_entries(nullptr)
+            , m_size(0)
+            , m_capacity(0)
+        {
+            ;
+        }
+
+        HashMap(HashMap&& t_other)
+            : HashMap()
+        {
+            swap_with(t_other);
+        }
+
+        HashMap& operator=(HashMap&& t_other) {
+            if (this != &t_other) {
+                destroy();
+                swap_with(t_other);
+            }
+            return *this;
+        }
+
+        HashMap(const HashMap&) = delete;
+        HashMap& operator=(const HashMap&) = delete;
+
+        ~HashMap() {
+            destroy();
+        }
+
+        // Makes room for t_count entries without growing again
+        Data::ErrorOr<void> reserve(size_t t_count) {
+            size_t capacity = (m_capacity == 0) ? MIN_CAPACITY : m_capacity;
+            while (is_over_load_limit(t_count, capacity)) {
+                capacity *= 2;
+            }
+
+            if (capacity != m_capacity) {
+                TRY(rehash(capacity));
+            }
+
+            return Data::ErrorOr<void>();
+        }
+
+        // Adds t_key, or replaces its value if it's already there
+        Data::ErrorOr<void> set(K t_key, V t_value) {
+            V* existing = find(t_key);
+            if (existing != nullptr) {
+                *existing = move(t_value);
+                return Data::ErrorOr<void>();
+            }
+
+            TRY(reserve(m_size + 1));
+            insert_new(Entry { move(t_key), move(t_value) });
+
+            return Data::ErrorOr<void>();
+        }
+
+        template <typename Q>
+        V* find(const Q& t_key) {
+            const size_t index = find_index(t_key);
+            return (index == NOT_FOUND) ? nullptr : &m_entries[index].value;
+        }
+
+        template <typename Q>
+        const V* find(const Q& t_key) const {
+            return const_cast<HashMap*>(this)->find(t_key);
+        }
+
+        template <typename Q>
+        [[nodiscard]] bool contains(const Q& t_key) const {
+            return find(t_key) != nullptr;
+        }
+
+        template <typename Q>
+        Data::ErrorOr<void> remove(const Q& t_key) {
+            size_t index = find_index(t_key);
+            ASSERT(index != NOT_FOUND, Error::CONTAINER_KEY_NOT_FOUND);
+
+            m_entries[index].~Entry();
+            m_distances[index] = 0;
+
+            // Pull the rest of the cluster one slot closer to home
+            size_t next = (index + 1) & get_mask();
+            while (m_distances[next] > 1) {
+                new (&m_entries[index]) Entry(move(m_entries[next]));
+                m_entries[next].~Entry();
+
+                m_distances[index] = m_distances[next] - 1;
+                m_distances[next] = 0;
+
+                index = next;
+                next = (next + 1) & get_mask();
+            }
+
+            m_size--;
+
+            return Data::ErrorOr<void>();
+        }
+
+        // Destroys every entry but keeps the table
+        void clear() {
+            for (size_t i = 0; i < m_capacity; i++) {
+                if (m_distances[i] != 0) {
+                    m_entries[i].~Entry();
+                    m_distances[i] = 0;
+                }
+            }
+            m_size = 0;
+        }
+
+        Iterator begin() {
+            return Iterator(*this, 0);
+        }
+
+        Iterator end() {
+            return Iterator(*this, m_capacity);
+        }
+
+        [[nodiscard]] size_t size() const {
+            return m_size;
+        }
+
+        [[nodiscard]] bool empty() const {
+            return size() == 0;
+        }
+
+        [[nodiscard]] size_t capacity() const {
+            return m_capacity;
+        }
+
+    private:
+        static constexpr size_t MIN_CAPACITY = 8;
+        static constexpr size_t NOT_FOUND = ~static_cast<size_t>(0);
+
+        // Grow once the table would be more than 7/8 full
+        static constexpr bool is_over_load_limit(size_t t_count, size_t t_capacity) {
+            return t_count * 8 > t_capacity * 7;
+        }
+
+        size_t get_mask() const {
+            return m_capacity - 1;
+        }
+
+        template <typename Q>
+        size_t find_index(const Q& t_key) const {
+            if (m_size == 0) {
+                return NOT_FOUND;
+            }
+
+            size_t index = Traits::hash(t_key) & get_mask();
+            for (u16 distance = 1; ; distance++) {
+                // Any entry of ours would have displaced one this close to home
+                if (m_distances[index] < distance) {
+                    return NOT_FOUND;
+                }
+                if (m_distances[index] == distance && Traits::equals(m_entries[index].key, t_key)) {
+                    return index;
+                }
+                index = (index + 1) & get_mask();
+            }
+        }
+
+        // t_entry's key must not be in the map and there must be a free slot
+        void insert_new(Entry&& t_entry) {
+            Entry carried(move(t_entry));
+
+            size_t index = Traits::hash(carried.key) & get_mask();
+            u16 distance = 1;
+
+            while (m_distances[index] != 0) {
+                // Robin Hood: whoever is further from home keeps the slot
+                if (m_distances[index] < distance) {
+                    swap(carried, m_entries[index]);
+                    swap(distance, m_distances[index]);
+                }
+
+                index = (index + 1) & get_mask();
+                distance++;
+            }
+
+            new (&m_entries[index]) Entry(move(carried));
+            m_distances[index] = distance;
+            m_size++;
+        }
+
+        Data::ErrorOr<void> rehash(size_t t_capacity) {
+            ASSERT(t_capacity <= MAX_CAPACITY, Error::CONTAINER_IS_FULL);
+
+            // One allocation, the distance array followed by the entries
+            const size_t distancesSize = get_smallest_gte_multiple(t_capacity * sizeof(u16), alignof(Entry));
+            u8* memory = static_cast<u8*>(TRY(Allocator::allocate(distancesSize + t_capacity * sizeof(Entry))));
+
+            u16* oldDistances = m_distances;
+            Entry* oldEntries = m_entries;
+            const size_t oldCapacity = m_capacity;
+
+            m_distances = reinterpret_cast<u16*>(memory);
+            m_entries = reinterpret_cast<Entry*>(memory + distancesSize);
+            m_capacity = t_capacity;
+            m_size = 0;
+            memset(m_distances, 0, t_capacity * sizeof(u16));
+
+            for (size_t i = 0; i < oldCapacity; i++) {
+                if (oldDistances[i] != 0) {
+                    insert_new(move(oldEntries[i]));
+                    oldEntries[i].~Entry();
+                }
+            }
+
+            if (oldDistances != nullptr) {
+                Allocator::deallocate(oldDistances);
+            }
+
+            return Data::ErrorOr<void>();
+        }
+
+        void destroy() {
+            clear();
+            if (m_distances != nullptr) {
+                Allocator::deallocate(m_distances);
+            }
+            m_distances = nullptr;
+            m_entries = nullptr;
+            m_capacity = 0;
+        }
+
+        void swap_with(HashMap& t_other) {
+            swap(m_distances, t_other.m_distances);
+            swap(m_entries, t_other.m_entries);
+            swap(m_size, t_other.m_size);
+            swap(m_capacity, t_other.m_capacity);
+        }
+
+        u16* m_distances; // 0 for an empty slot, otherwise 1 + how far the entry is from its home slot
+        Entry* m_entries;
+        size_t m_size;
+        size_t m_capacity; // a power of two
+    };
+
+}
+
+#endif
@@ -0,0 +1,153 @@
+#ifndef DATA_INTRUSIVE_LIST_INCLUDED
+#define DATA_INTRUSIVE_LIST_INCLUDED
+
+#include "common.hpp"
+
+namespace Kernel::Data {
+
+    // Embedded in the object that goes on the list, so linking and unlinking never allocate.
+    // An object can be on as many lists at once as it has nodes
+    struct IntrusiveListNode {
+        IntrusiveListNode* previous = nullptr;
+        IntrusiveListNode* next = nullptr;
+
+        [[nodiscard]] bool is_linked() const {
+            return next != nullptr;
+        }
+    };
+
+    // Gets the object a node member is embedded in
+    template <typename T, typename Node, Node T::*MEMBER>
+    T* get_owner(Node* t_node) {
+        const uintptr_t offset = reinterpret_cast<uintptr_t>(&(static_cast<T*>(nullptr)->*MEMBER));
+        return reinterpret_cast<T*>(reinterpret_cast<u8*>(t_node) - offset);
+    }
+
+    // Circular doubly linked list of T, linked through T's NODE member. Every operation is O(1) apart from size.
+    // The list doesn't own its elements, remove them before they are destroyed
+    template <typename T, IntrusiveListNode T::*NODE>
+    class IntrusiveList {
+    public:
+        class Iterator {
+        public:
+            explicit Iterator(IntrusiveListNode* t_node) : m_node(t_node) {
+                ;
+            }
+
+            T& operator*() const {
+                return *get_owner<T, IntrusiveListNode, NODE>(m_node);
+            }
+
+            T* operator->() const {
+                return get_owner<T, IntrusiveListNode, NODE>(m_node);
+            }
+
+            Iterator& operator++() {
+                m_node = m_node->next;
+                return *this;
+            }
+
+            bool operator!=(const Iterator& t_other) const {
+                return m_node != t_other.m_node;
+            }
+
+        private:
+            IntrusiveListNode* m_node;
+        };
+
+        constexpr IntrusiveList()
+            : m_sentinel { &m_sentinel, &m_sentinel }
+        {
+            ;
+        }
+
+        // Elements point back at the sentinel, so the list can't move
+        IntrusiveList(const IntrusiveList&) = delete;
+        IntrusiveList& operator=(const IntrusiveList&) = delete;
+
+        void push_back(T& t_element) {
+            link_before(&m_sentinel, &(t_element.*NODE));
+        }
+
+        void push_front(T& t_element) {
+            link_before(m_sentinel.next, &(t_element.*NODE));
+        }
+
+        // Links t_element in front of t_position, which must be on this list
+        void insert_before(T& t_position, T& t_element) {
+            link_before(&(t_position.*NODE), &(t_element.*NODE));
+        }
+
+        // t_element must be on this list
+        void remove(T& t_element) {
+            IntrusiveListNode* node = &(t_element.*NODE);
+
+            node->previous->next = node->next;
+            node->next->previous = node->previous;
+            node->previous = nullptr;
+            node->next = nullptr;
+        }
+
+        // Unlinks and returns the first element, nullptr if the list is empty
+        T* pop_front() {
+            T* element = front();
+            if (element != nullptr) {
+                remove(*element);
+            }
+            return element;
+        }
+
+        T* front() const {
+            return is_empty() ? nullptr : get_owner<T, IntrusiveListNode, NODE>(m_sentinel.next);
+        }
+
+        T* back() const {
+            return is_empty() ? nullptr : get_owner<T, IntrusiveListNode, NODE>(m_sentinel.previous);
+        }
+
+        // Element after t_element, nullptr if it is the last. Fetch it before removing t_element
+        T* next(T& t_element) const {
+            IntrusiveListNode* node = (t_element.*NODE).next;
+            return (node == &m_sentinel) ? nullptr : get_owner<T, IntrusiveListNode, NODE>(node);
+        }
+
+        // Element before t_element, nullptr if it is the first
+        T* previous(T& t_element) const {
+            IntrusiveListNode* node = (t_element.*NODE).previous;
+            return (node == &m_sentinel) ? nullptr : get_owner<T, IntrusiveListNode, NODE>(node);
+        }
+
+        [[nodiscard]] bool is_empty() const {
+            return m_sentinel.next == &m_sentinel;
+        }
+
+        [[nodiscard]] size_t size() const {
+            size_t count = 0;
+            for (const IntrusiveListNode* node = m_sentinel.next; node != &m_sentinel; node = node->next) {
+                count++;
+            }
+            return count;
+        }
+
+        Iterator begin() {
+            return Iterator(m_sentinel.next);
+        }
+
+        Iterator end() {
+            return Iterator(&m_sentinel);
+        }
+
+    private:
+        static void link_before(IntrusiveListNode* t_position, IntrusiveListNode* t_node) {
+            t_node->previous = t_position->previous;
+            t_node->next = t_position;
+            t_position->previous->next = t_node;
+            t_position->previous = t_node;
+        }
+
+        IntrusiveListNode m_sentinel;
+    };
+
+}
+
+#endif
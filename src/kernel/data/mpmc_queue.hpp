@@ -0,0 +1,126 @@
+#ifndef MPMC_QUEUE_INCLUDED
+#define MPMC_QUEUE_INCLUDED
+
+#include "common.hpp"
+#include "data/error_or.hpp"
+
+namespace Kernel::Data {
+
+    // Bounded lock-free queue for any number of producers and consumers on any CPU (Vyukov's bounded MPMC queue).
+    // Every cell carries a sequence number saying whose turn it is: pos when it's free for the producer that
+    // claims position pos, pos + 1 once that element can be taken. Producers and consumers only contend on
+    // their own position counter, and a cell is handed over with a single release store.
+    // push only fails when the queue is full and pop only when it is empty
+    template <typename T, size_t SIZE>
+    class MPMCQueue {
+        static_assert(SIZE >= 2 && (SIZE & (SIZE - 1)) == 0, "Size must be a power of two");
+
+    public:
+        MPMCQueue()
+            : m_enqueuePosition(0)
+            , m_dequeuePosition(0)
+        {
+            for (size_t i = 0; i < SIZE; i++) {
+                m_cells[i].sequence = i;
+            }
+        }
+
+        MPMCQueue(const MPMCQueue&) = delete;
+        MPMCQueue& operator=(const MPMCQueue&) = delete;
+
+        Data::ErrorOr<void> push(const T& t_element) {
+            u32 position = __atomic_load_n(&m_enqueuePosition, __ATOMIC_RELAXED);
+            Cell* cell;
+
+            while (true) {
+                cell = &m_cells[position & MASK];
+                const u32 sequence = __atomic_load_n(&cell->sequence, __ATOMIC_ACQUIRE);
+                const s32 difference = static_cast<s32>(sequence - position);
+
+                if (difference == 0) {
+                    // On failure position is reloaded with the current value
+                    if (__atomic_compare_exchange_n(&m_enqueuePosition, &position, position + 1, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+                        break;
+                    }
+                }
+                else if (difference < 0) {
+                    // The cell still holds the element from one lap ago
+                    return Error::CONTAINER_IS_FULL;
+                }
+                else {
+                    // Another producer claimed it first
+                    position = __atomic_load_n(&m_enqueuePosition, __ATOMIC_RELAXED);
+                }
+            }
+
+            cell->data = t_element;
+            __atomic_store_n(&cell->sequence, position + 1, __ATOMIC_RELEASE);
+
+            return Data::ErrorOr<void>();
+        }
+
+        Data::ErrorOr<T> pop() {
+            u32 position = __atomic_load_n(&m_dequeuePosition, __ATOMIC_RELAXED);
+            Cell* cell;
+
+            while (true) {
+                cell = &m_cells[position & MASK];
+                const u32 sequence = __atomic_load_n(&cell->sequence, __ATOMIC_ACQUIRE);
+                const s32 difference = static_cast<s32>(sequence - (position + 1));
+
+                if (difference == 0) {
+                    if (__atomic_compare_exchange_n(&m_dequeuePosition, &position, position + 1, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+                        break;
+                    }
+                }
+                else if (difference < 0) {
+                    // Nothing has been published in this cell yet
+                    return Error::CONTAINER_IS_EMPTY;
+                }
+                else {
+                    position = __atomic_load_n(&m_dequeuePosition, __ATOMIC_RELAXED);
+                }
+            }
+
+            const T element = cell->data;
+            // Frees the cell for the producer one lap later
+            __atomic_store_n(&cell->sequence, position + SIZE, __ATOMIC_RELEASE);
+
+            return element;
+        }
+
+        // Only a hint while other CPUs are using the queue
+        [[nodiscard]] size_t size() const {
+            const u32 enqueuePosition = __atomic_load_n(&m_enqueuePosition, __ATOMIC_RELAXED);
+            const u32 dequeuePosition = __atomic_load_n(&m_dequeuePosition, __ATOMIC_RELAXED);
+            const s32 size = static_cast<s32>(enqueuePosition - dequeuePosition);
+
+            return (size < 0) ? 0 : static_cast<size_t>(size);
+        }
+
+        [[nodiscard]] bool is_empty() const {
+            return size() == 0;
+        }
+
+        static constexpr size_t capacity() {
+            return SIZE;
+        }
+
+    private:
+        static constexpr u32 MASK = SIZE - 1;
+
+        struct Cell {
+            u32 sequence;
+            T data;
+        };
+
+        Cell m_cells[SIZE];
+
+        // Producers and consumers each hammer their own counter, keep them on separate cache lines
+        alignas(64) u32 m_enqueuePosition;
+        alignas(64) u32 m_dequeuePosition;
+    };
+
+}
+
+#endif
@@ -0,0 +1,348 @@
+#ifndef DATA_RB_TREE_INCLUDED
+#define DATA_RB_TREE_INCLUDED
+
+#include "common.hpp"
+#include "data/intrusive_list.hpp"
+
+namespace Kernel::Data {
+
+    struct RBTreeNode {
+        RBTreeNode* parent = nullptr;
+        RBTreeNode* left = nullptr;
+        RBTreeNode* right = nullptr;
+        bool red = false;
+        bool linked = false;
+
+        [[nodiscard]] bool is_linked() const {
+            return linked;
+        }
+    };
+
+    // Intrusive red-black tree of T, linked through T's NODE member, so inserting never allocates.
+    // Ordered by Compare::less(const T&, const T&); equal elements are kept in insertion order.
+    // Insert and remove are O(log n), and the smallest element is cached so first() is O(1).
+    // The tree doesn't own its elements, remove them before they are destroyed
+    template <typename T, RBTreeNode T::*NODE, typename Compare>
+    class RBTree {
+    public:
+        constexpr RBTree()
+            : m_root(nullptr)
+            , m_first(nullptr)
+        {
+            ;
+        }
+
+        RBTree(const RBTree&) = delete;
+        RBTree& operator=(const RBTree&) = delete;
+
+        void insert(T& t_element) {
+            RBTreeNode* node = &(t_element.*NODE);
+            RBTreeNode* parent = nullptr;
+            RBTreeNode** link = &m_root;
+            bool isFirst = true;
+
+            while (*link != nullptr) {
+                parent = *link;
+                if (Compare::less(t_element, *get_element(parent))) {
+                    link = &parent->left;
+                }
+                else {
+                    link = &parent->right;
+                    isFirst = false;
+                }
+            }
+
+            *node = RBTreeNode { parent, nullptr, nullptr, true, true };
+            *link = node;
+            if (isFirst) {
+                m_first = node;
+            }
+
+            fix_after_insert(node);
+        }
+
+        // t_element must be in this tree
+        void remove(T& t_element) {
+            RBTreeNode* node = &(t_element.*NODE);
+
+            if (m_first == node) {
+                m_first = get_successor(node);
+            }
+
+            // child takes the place of whichever node is unlinked from its spot in the tree
+            RBTreeNode* child;
+            RBTreeNode* childParent;
+            bool removedRed = node->red;
+
+            if (node->left == nullptr) {
+                child = node->right;
+                childParent = node->parent;
+                transplant(node, node->right);
+            }
+            else if (node->right == nullptr) {
+                child = node->left;
+                childParent = node->parent;
+                transplant(node, node->left);
+            }
+            else {
+                // Two children, the successor moves into node's place
+                RBTreeNode* successor = get_minimum(node->right);
+                removedRed = successor->red;
+                child = successor->right;
+
+                if (successor->parent == node) {
+                    childParent = successor;
+                }
+                else {
+                    childParent = successor->parent;
+                    transplant(successor, successor->right);
+                    successor->right = node->right;
+                    successor->right->parent = successor;
+                }
+
+                transplant(node, successor);
+                successor->left = node->left;
+                successor->left->parent = successor;
+                successor->red = node->red;
+            }
+
+            if (!removedRed) {
+                fix_after_remove(child, childParent);
+            }
+
+            *node = RBTreeNode {};
+        }
+
+        // Smallest element, nullptr if the tree is empty
+        T* first() const {
+            return (m_first == nullptr) ? nullptr : get_element(m_first);
+        }
+
+        // Element after t_element in order, nullptr if it is the last
+        T* next(T& t_element) const {
+            RBTreeNode* successor = get_successor(&(t_element.*NODE));
+            return (successor == nullptr) ? nullptr : get_element(successor);
+        }
+
+        // First element that isn't less than t_key, needs Compare::less(const T&, const Q&)
+        template <typename Q>
+        T* lower_bound(const Q& t_key) const {
+            RBTreeNode* result = nullptr;
+            for (RBTreeNode* node = m_root; node != nullptr; ) {
+                if (Compare::less(*get_element(node), t_key)) {
+                    node = node->right;
+                }
+                else {
+                    result = node;
+                    node = node->left;
+                }
+            }
+            return (result == nullptr) ? nullptr : get_element(result);
+        }
+
+        [[nodiscard]] bool is_empty() const {
+            return m_root == nullptr;
+        }
+
+    private:
+        static T* get_element(RBTreeNode* t_node) {
+            return get_owner<T, RBTreeNode, NODE>(t_node);
+        }
+
+        static bool is_red(const RBTreeNode* t_node) {
+            return t_node != nullptr && t_node->red;
+        }
+
+        static RBTreeNode* get_minimum(RBTreeNode* t_node) {
+            while (t_node->left != nullptr) {
+                t_node = t_node->left;
+            }
+            return t_node;
+        }
+
+        static RBTreeNode* get_successor(RBTreeNode* t_node) {
+            if (t_node->right != nullptr) {
+                return get_minimum(t_node->right);
+            }
+
+            RBTreeNode* parent = t_node->parent;
+            while (parent != nullptr && t_node == parent->right) {
+                t_node = parent;
+                parent = parent->parent;
+            }
+            return parent;
+        }
+
+        void replace_child(RBTreeNode* t_parent, RBTreeNode* t_old, RBTreeNode* t_new) {
+            if (t_parent == nullptr) {
+                m_root = t_new;
+            }
+            else if (t_parent->left == t_old) {
+                t_parent->left = t_new;
+            }
+            else {
+                t_parent->right = t_new;
+            }
+        }
+
+        // Puts t_new (which may be nullptr) where t_old hangs from its parent
+        void transplant(RBTreeNode* t_old, RBTreeNode* t_new) {
+            replace_child(t_old->parent, t_old, t_new);
+            if (t_new != nullptr) {
+                t_new->parent = t_old->parent;
+            }
+        }
+
+        void rotate_left(RBTreeNode* t_node) {
+            RBTreeNode* right = t_node->right;
+
+            t_node->right = right->left;
+            if (right->left != nullptr) {
+                right->left->parent = t_node;
+            }
+
+            right->parent = t_node->parent;
+            replace_child(t_node->parent, t_node, right);
+
+            right->left = t_node;
+            t_node->parent = right;
+        }
+
+        void rotate_right(RBTreeNode* t_node) {
+            RBTreeNode* left = t_node->left;
+
+            t_node->left = left->right;
+            if (left->right != nullptr) {
+                left->right->parent = t_node;
+            }
+
+            left->parent = t_node->parent;
+            replace_child(t_node->parent, t_node, left);
+
+            left->right = t_node;
+            t_node->parent = left;
+        }
+
+        // Restores "no red node has a red child" after linking a red leaf
+        void fix_after_insert(RBTreeNode* t_node) {
+            while (is_red(t_node->parent)) {
+                RBTreeNode* parent = t_node->parent;
+                RBTreeNode* grandparent = parent->parent; // exists, the root is never red here
+
+                if (parent == grandparent->left) {
+                    RBTreeNode* uncle = grandparent->right;
+                    if (is_red(uncle)) {
+                        parent->red = false;
+                        uncle->red = false;
+                        grandparent->red = true;
+                        t_node = grandparent;
+                        continue;
+                    }
+
+                    if (t_node == parent->right) {
+                        rotate_left(parent);
+                        t_node = parent;
+                        parent = t_node->parent;
+                    }
+                    parent->red = false;
+                    grandparent->red = true;
+                    rotate_right(grandparent);
+                }
+                else {
+                    RBTreeNode* uncle = grandparent->left;
+                    if (is_red(uncle)) {
+                        parent->red = false;
+                        uncle->red = false;
+                        grandparent->red = true;
+                        t_node = grandparent;
+                        continue;
+                    }
+
+                    if (t_node == parent->left) {
+                        rotate_right(parent);
+                        t_node = parent;
+                        parent = t_node->parent;
+                    }
+                    parent->red = false;
+                    grandparent->red = true;
+                    rotate_left(grandparent);
+                }
+            }
+
+            m_root->red = false;
+        }
+
+        // Restores equal black heights after a black node was unlinked. t_node (possibly nullptr) carries the
+        // missing black, t_parent is its parent since a nullptr child can't tell us
+        void fix_after_remove(RBTreeNode* t_node, RBTreeNode* t_parent) {
+            while (t_node != m_root && !is_red(t_node)) {
+                if (t_node == t_parent->left) {
+                    RBTreeNode* sibling = t_parent->right;
+                    if (is_red(sibling)) {
+                        sibling->red = false;
+                        t_parent->red = true;
+                        rotate_left(t_parent);
+                        sibling = t_parent->right;
+                    }
+
+                    if (!is_red(sibling->left) && !is_red(sibling->right)) {
+                        sibling->red = true;
+                        t_node = t_parent;
+                        t_parent = t_node->parent;
+                        continue;
+                    }
+
+                    if (!is_red(sibling->right)) {
+                        sibling->left->red = false;
+                        sibling->red = true;
+                        rotate_right(sibling);
+                        sibling = t_parent->right;
+                    }
+                    sibling->red = t_parent->red;
+                    t_parent->red = false;
+                    sibling->right->red = false;
+                    rotate_left(t_parent);
+                    t_node = m_root;
+                }
+                else {
+                    RBTreeNode* sibling = t_parent->left;
+                    if (is_red(sibling)) {
+                        sibling->red = false;
+                        t_parent->red = true;
+                        rotate_right(t_parent);
+                        sibling = t_parent->left;
+                    }
+
+                    if (!is_red(sibling->left) && !is_red(sibling->right)) {
+                        sibling->red = true;
+                        t_node = t_parent;
+                        t_parent = t_node->parent;
+                        continue;
+                    }
+
+                    if (!is_red(sibling->left)) {
+                        sibling->right->red = false;
+                        sibling->red = true;
+                        rotate_left(sibling);
+                        sibling = t_parent->left;
+                    }
+                    sibling->red = t_parent->red;
+                    t_parent->red = false;
+                    sibling->left->red = false;
+                    rotate_right(t_parent);
+                    t_node = m_root;
+                }
+            }
+
+            if (t_node != nullptr) {
+                t_node->red = false;
+            }
+        }
+
+        RBTreeNode* m_root;
+        RBTreeNode* m_first; // leftmost node
+    };
+
+}
+
+#endif
@@ -0,0 +1,103 @@
+#ifndef SPSC_RING_INCLUDED
+#define SPSC_RING_INCLUDED
+
+#include "common.hpp"
+#include "data/error_or.hpp"
+
+namespace Kernel::Data {
+
+    // Lock-free single producer, single consumer ring, the standard way to hand data from an interrupt handler
+    // to whoever drains it. The producer only writes m_tail and the consumer only writes m_head; both indices run
+    // freely and are masked on access, so all SIZE slots are usable.
+    // Several producers (or consumers) are fine as long as the caller serialises them, e.g. with interrupts disabled
+    template <typename T, size_t SIZE>
+    class SPSCRing {
+        static_assert(SIZE != 0 && (SIZE & (SIZE - 1)) == 0, "Size must be a power of two");
+
+    public:
+        constexpr SPSCRing()
+            : m_head(0)
+            , m_tail(0)
+        {
+            ;
+        }
+
+        SPSCRing(const SPSCRing&) = delete;
+        SPSCRing& operator=(const SPSCRing&) = delete;
+
+        // Producer only
+        Data::ErrorOr<void> push(const T& t_element) {
+            return (push_n(&t_element, 1) == 1) ? Data::ErrorOr<void>() : Data::ErrorOr<void>(Error::CONTAINER_IS_FULL);
+        }
+
+        // Producer only, pushes as many of t_elements as fit and returns how many that was
+        size_t push_n(const T* t_elements, size_t t_count) {
+            const u32 tail = __atomic_load_n(&m_tail, __ATOMIC_RELAXED);
+            const u32 head = __atomic_load_n(&m_head, __ATOMIC_ACQUIRE); // the consumer is done with the slots before head
+
+            const size_t space = SIZE - (tail - head);
+            const size_t count = (t_count < space) ? t_count : space;
+
+            for (size_t i = 0; i < count; i++) {
+                m_data[(tail + i) & MASK] = t_elements[i];
+            }
+            __atomic_store_n(&m_tail, tail + count, __ATOMIC_RELEASE); // publishes the slots written above
+
+            return count;
+        }
+
+        // Consumer only
+        Data::ErrorOr<T> pop() {
+            T element;
+            if (pop_n(&element, 1) == 0) {
+                return Error::CONTAINER_IS_EMPTY;
+            }
+            return element;
+        }
+
+        // Consumer only, moves up to t_maxCount elements into r_elements and returns how many that was
+        size_t pop_n(T* r_elements, size_t t_maxCount) {
+            const u32 head = __atomic_load_n(&m_head, __ATOMIC_RELAXED);
+            const u32 tail = __atomic_load_n(&m_tail, __ATOMIC_ACQUIRE);
+
+            const size_t available = tail - head;
+            const size_t count = (t_maxCount < available) ? t_maxCount : available;
+
+            for (size_t i = 0; i < count; i++) {
+                r_elements[i] = m_data[(head + i) & MASK];
+            }
+            __atomic_store_n(&m_head, head + count, __ATOMIC_RELEASE); // hands the slots back to the producer
+
+            return count;
+        }
+
+        // Exact for the producer and consumer, only a hint for anyone else
+        [[nodiscard]] size_t size() const {
+            return __atomic_load_n(&m_tail, __ATOMIC_ACQUIRE) - __atomic_load_n(&m_head, __ATOMIC_ACQUIRE);
+        }
+
+        [[nodiscard]] bool is_empty() const {
+            return size() == 0;
+        }
+
+        [[nodiscard]] bool is_full() const {
+            return size() == SIZE;
+        }
+
+        static constexpr size_t capacity() {
+            return SIZE;
+        }
+
+    private:
+        static constexpr u32 MASK = SIZE - 1;
+
+        T m_data[SIZE];
+
+        // Written by different CPUs, so keep them on separate cache lines
+        alignas(64) u32 m_head;
+        alignas(64) u32 m_tail;
+    };
+
+}
+
+#endif
@@ -0,0 +1,51 @@
+#ifndef DATA_UTILITY_INCLUDED
+#define DATA_UTILITY_INCLUDED
+
+#include <stddef.h>
+
+// There's no <new> without libstdc++, containers use this to construct elements in raw storage
+inline void* operator new(size_t t_size, void* t_address) noexcept {
+    (void)t_size;
+    return t_address;
+}
+
+namespace Kernel::Data {
+
+    template <typename T> struct RemoveReference { using Type = T; };
+    template <typename T> struct RemoveReference<T&> { using Type = T; };
+    template <typename T> struct RemoveReference<T&&> { using Type = T; };
+
+    template <bool CONDITION, typename IfTrue, typename IfFalse> struct Conditional { using Type = IfTrue; };
+    template <typename IfTrue, typename IfFalse> struct Conditional<false, IfTrue, IfFalse> { using Type = IfFalse; };
+
+    template <typename T>
+    constexpr typename RemoveReference<T>::Type&& move(T&& t_value) {
+        return static_cast<typename RemoveReference<T>::Type&&>(t_value);
+    }
+
+    template <typename T>
+    constexpr T&& forward(typename RemoveReference<T>::Type& t_value) {
+        return static_cast<T&&>(t_value);
+    }
+
+    template <typename T>
+    constexpr T&& forward(typename RemoveReference<T>::Type&& t_value) {
+        return static_cast<T&&>(t_value);
+    }
+
+    template <typename T>
+    constexpr void swap(T& r_a, T& r_b) {
+        T temporary = move(r_a);
+        r_a = move(r_b);
+        r_b = move(temporary);
+    }
+
+    // Types that can be moved to a new address with memcpy and have nothing to do when destroyed
+    template <typename T>
+    constexpr bool is_trivially_relocatable() {
+        return __is_trivially_copyable(T);
+    }
+
+}
+
+#endif
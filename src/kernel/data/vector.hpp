@@ -0,0 +1,288 @@
+#ifndef DATA_VECTOR_INCLUDED
+#define DATA_VECTOR_INCLUDED
+
+#include "common.hpp"
+#include "data/allocator.hpp"
+#include "data/error_or.hpp"
+#include "data/utility.hpp"
+
+namespace Kernel::Data {
+
+    // Growable array. Capacity doubles when it runs out, and elements are moved (or memcpy'd when T is
+    // trivially copyable) into the new storage. The first INLINE_CAPACITY elements live inside the vector
+    // itself, so small vectors never touch the heap (see SmallVector).
+    // Pointers and references to elements are invalidated by anything that adds or removes elements
+    template <typename T, size_t INLINE_CAPACITY = 0, typename Allocator = KernelAllocator>
+    class Vector {
+    public:
+        Vector()
+            : m_data(inline_data())
+            , m_size(0)
+            , m_capacity(INLINE_CAPACITY)
+        {
+            ;
+        }
+
+        Vector(Vector&& t_other)
+            : Vector()
+        {
+            take_from(t_other);
+        }
+
+        Vector& operator=(Vector&& t_other) {
+            if (this != &t_other) {
+                clear();
+                release_storage();
+                take_from(t_other);
+            }
+            return *this;
+        }
+
+        // Copying can run out of memory, which a constructor couldn't report
+        Vector(const Vector&) = delete;
+        Vector& operator=(const Vector&) = delete;
+
+        ~Vector() {
+            clear();
+            release_storage();
+        }
+
+        Data::ErrorOr<void> reserve(size_t t_capacity) {
+            if (t_capacity <= m_capacity) {
+                return Data::ErrorOr<void>();
+            }
+
+            T* data = static_cast<T*>(TRY(Allocator::allocate(t_capacity * sizeof(T))));
+            relocate(data, m_data, m_size);
+            release_storage();
+
+            m_data = data;
+            m_capacity = t_capacity;
+
+            return Data::ErrorOr<void>();
+        }
+
+        template <typename... Args>
+        Data::ErrorOr<void> emplace_back(Args&&... t_arguments) {
+            if (m_size < m_capacity) {
+                new (&m_data[m_size]) T(forward<Args>(t_arguments)...);
+                m_size++;
+                return Data::ErrorOr<void>();
+            }
+
+            // The new element is built before the old ones move, in case the arguments refer to one of them
+            const size_t capacity = get_grown_capacity();
+            T* data = static_cast<T*>(TRY(Allocator::allocate(capacity * sizeof(T))));
+            new (&data[m_size]) T(forward<Args>(t_arguments)...);
+
+            relocate(data, m_data, m_size);
+            release_storage();
+
+            m_data = data;
+            m_capacity = capacity;
+            m_size++;
+
+            return Data::ErrorOr<void>();
+        }
+
+        Data::ErrorOr<void> push_back(const T& t_value) {
+            return emplace_back(t_value);
+        }
+
+        Data::ErrorOr<void> push_back(T&& t_value) {
+            return emplace_back(move(t_value));
+        }
+
+        // Taken by value so that inserting one of the vector's own elements is safe
+        Data::ErrorOr<void> insert(size_t t_index, T t_value) {
+            ASSERT(t_index <= m_size, Error::INDEX_OUT_OF_RANGE);
+
+            if (t_index == m_size) {
+                return emplace_back(move(t_value));
+            }
+
+            if (m_size == m_capacity) {
+                TRY(reserve(get_grown_capacity()));
+            }
+
+            if constexpr (is_trivially_relocatable<T>()) {
+                memmove(&m_data[t_index + 1], &m_data[t_index], (m_size - t_index) * sizeof(T));
+                new (&m_data[t_index]) T(move(t_value));
+            }
+            else {
+                new (&m_data[m_size]) T(move(m_data[m_size - 1]));
+                for (size_t i = m_size - 1; i > t_index; i--) {
+                    m_data[i] = move(m_data[i - 1]);
+                }
+                m_data[t_index] = move(t_value);
+            }
+            m_size++;
+
+            return Data::ErrorOr<void>();
+        }
+
+        Data::ErrorOr<void> remove(size_t t_index) {
+            ASSERT(t_index < m_size, Error::INDEX_OUT_OF_RANGE);
+
+            if constexpr (is_trivially_relocatable<T>()) {
+                memmove(&m_data[t_index], &m_data[t_index + 1], (m_size - t_index - 1) * sizeof(T));
+            }
+            else {
+                for (size_t i = t_index; i + 1 < m_size; i++) {
+                    m_data[i] = move(m_data[i + 1]);
+                }
+                m_data[m_size - 1].~T();
+            }
+            m_size--;
+
+            return Data::ErrorOr<void>();
+        }
+
+        Data::ErrorOr<void> pop_back() {
+            ASSERT(m_size != 0, Error::CONTAINER_IS_EMPTY);
+
+            m_data[m_size - 1].~T();
+            m_size--;
+
+            return Data::ErrorOr<void>();
+        }
+
+        // Destroys every element but keeps the storage
+        void clear() {
+            for (size_t i = 0; i < m_size; i++) {
+                m_data[i].~T();
+            }
+            m_size = 0;
+        }
+
+        T& operator[](size_t t_index) {
+            return m_data[t_index];
+        }
+
+        const T& operator[](size_t t_index) const {
+            return m_data[t_index];
+        }
+
+        T& back() {
+            return m_data[m_size - 1];
+        }
+
+        T* begin() {
+            return m_data;
+        }
+
+        T* end() {
+            return m_data + m_size;
+        }
+
+        const T* begin() const {
+            return m_data;
+        }
+
+        const T* end() const {
+            return m_data + m_size;
+        }
+
+        T* data() {
+            return m_data;
+        }
+
+        [[nodiscard]] size_t size() const {
+            return m_size;
+        }
+
+        [[nodiscard]] bool empty() const {
+            return size() == 0;
+        }
+
+        [[nodiscard]] size_t capacity() const {
+            return m_capacity;
+        }
+
+        // True until the elements have outgrown the inline storage
+        [[nodiscard]] bool is_inline() const {
+            return m_data == inline_data();
+        }
+
+    private:
+        static constexpr size_t MIN_HEAP_CAPACITY = 4;
+
+        struct NoInlineStorage {
+            ;
+        };
+
+        struct alignas(T) InlineStorage {
+            u8 bytes[(INLINE_CAPACITY == 0 ? 1 : INLINE_CAPACITY) * sizeof(T)];
+        };
+
+        T* inline_data() {
+            if constexpr (INLINE_CAPACITY == 0) {
+                return nullptr;
+            }
+            else {
+                return reinterpret_cast<T*>(m_inlineStorage.bytes);
+            }
+        }
+
+        const T* inline_data() const {
+            return const_cast<Vector*>(this)->inline_data();
+        }
+
+        size_t get_grown_capacity() const {
+            return (m_capacity * 2 < MIN_HEAP_CAPACITY) ? MIN_HEAP_CAPACITY : m_capacity * 2;
+        }
+
+        // Moves t_count elements into uninitialized storage and destroys the originals
+        static void relocate(T* r_destination, T* t_source, size_t t_count) {
+            if constexpr (is_trivially_relocatable<T>()) {
+                if (t_count != 0) {
+                    memcpy(r_destination, t_source, t_count * sizeof(T));
+                }
+            }
+            else {
+                for (size_t i = 0; i < t_count; i++) {
+                    new (&r_destination[i]) T(move(t_source[i]));
+                    t_source[i].~T();
+                }
+            }
+        }
+
+        // Frees heap storage (the elements must already be gone or relocated) and goes back to the inline storage
+        void release_storage() {
+            if (!is_inline()) {
+                Allocator::deallocate(m_data);
+            }
+            m_data = inline_data();
+            m_capacity = INLINE_CAPACITY;
+        }
+
+        // Expects this to be empty and using its inline storage, leaves t_other the same way
+        void take_from(Vector& t_other) {
+            if (t_other.is_inline()) {
+                relocate(m_data, t_other.m_data, t_other.m_size);
+            }
+            else {
+                m_data = t_other.m_data;
+                m_capacity = t_other.m_capacity;
+            }
+            m_size = t_other.m_size;
+
+            t_other.m_data = t_other.inline_data();
+            t_other.m_size = 0;
+            t_other.m_capacity = INLINE_CAPACITY;
+        }
+
+        T* m_data;
+        size_t m_size;
+        size_t m_capacity;
+
+        [[no_unique_address]] typename Conditional<INLINE_CAPACITY == 0, NoInlineStorage, InlineStorage>::Type m_inlineStorage;
+    };
+
+    // Vector that keeps up to INLINE_CAPACITY elements inside itself before it moves to the heap
+    template <typename T, size_t INLINE_CAPACITY, typename Allocator = KernelAllocator>
+    using SmallVector = Vector<T, INLINE_CAPACITY, Allocator>;
+
+}
+
+#endif
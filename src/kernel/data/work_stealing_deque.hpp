@@ -0,0 +1,105 @@
+#ifndef WORK_STEALING_DEQUE_INCLUDED
+#define WORK_STEALING_DEQUE_INCLUDED
+
+#include "common.hpp"
+#include "data/error_or.hpp"
+
+namespace Kernel::Data {
+
+    // Fixed size Chase-Lev deque (Le et al., "Correct and Efficient Work-Stealing for Weak Memory Models").
+    // Only the owner may push and pop, and it pops from the bottom; any other CPU may steal from the top.
+    // T must be small enough to be copied without tearing (e.g. a pointer).
+    template <typename T, size_t SIZE>
+    class WorkStealingDeque {
+        static_assert((SIZE & (SIZE - 1)) == 0, "Size must be a power of two");
+
+    public:
+        WorkStealingDeque()
+            : m_top(0)
+            , m_bottom(0)
+        {
+            ;
+        }
+
+        // Owner only
+        Data::ErrorOr<void> push(T t_element) {
+            const s32 bottom = __atomic_load_n(&m_bottom, __ATOMIC_RELAXED);
+            const s32 top = __atomic_load_n(&m_top, __ATOMIC_ACQUIRE);
+
+            if (bottom - top >= static_cast<s32>(SIZE)) {
+                return Error::CONTAINER_IS_FULL;
+            }
+
+            __atomic_store_n(&m_data[bottom & MASK], t_element, __ATOMIC_RELAXED);
+            __atomic_thread_fence(__ATOMIC_RELEASE);
+            __atomic_store_n(&m_bottom, bottom + 1, __ATOMIC_RELAXED);
+
+            return Data::ErrorOr<void>();
+        }
+
+        // Owner only, takes the most recently pushed element
+        Data::ErrorOr<T> pop() {
+            const s32 bottom = __atomic_load_n(&m_bottom, __ATOMIC_RELAXED) - 1;
+            __atomic_store_n(&m_bottom, bottom, __ATOMIC_RELAXED);
+            __atomic_thread_fence(__ATOMIC_SEQ_CST);
+            const s32 top = __atomic_load_n(&m_top, __ATOMIC_RELAXED);
+
+            if (top > bottom) {
+                __atomic_store_n(&m_bottom, bottom + 1, __ATOMIC_RELAXED);
+                return Error::CONTAINER_IS_EMPTY;
+            }
+
+            const T element = __atomic_load_n(&m_data[bottom & MASK], __ATOMIC_RELAXED);
+            if (top != bottom) {
+                return element;
+            }
+
+            // Last element, race the thieves for it
+            s32 expected = top;
+            const bool won = __atomic_compare_exchange_n(&m_top, &expected, top + 1, false, __ATOMIC_SEQ_CST, __ATOMIC_RELAXED);
+            __atomic_store_n(&m_bottom, bottom + 1, __ATOMIC_RELAXED);
+
+            if (!won) {
+                return Error::CONTAINER_IS_EMPTY;
+            }
+            return element;
+        }
+
+        // Any CPU, takes the oldest element. Also fails when another thief got there first, so callers just move on
+        Data::ErrorOr<T> steal() {
+            s32 top = __atomic_load_n(&m_top, __ATOMIC_ACQUIRE);
+            __atomic_thread_fence(__ATOMIC_SEQ_CST);
+            const s32 bottom = __atomic_load_n(&m_bottom, __ATOMIC_ACQUIRE);
+
+            if (top >= bottom) {
+                return Error::CONTAINER_IS_EMPTY;
+            }
+
+            const T element = __atomic_load_n(&m_data[top & MASK], __ATOMIC_RELAXED);
+            if (!__atomic_compare_exchange_n(&m_top, &top, top + 1, false, __ATOMIC_SEQ_CST, __ATOMIC_RELAXED)) {
+                return Error::CONTAINER_IS_EMPTY;
+            }
+
+            return element;
+        }
+
+        // Only a hint when called by anyone but the owner
+        [[nodiscard]] bool is_empty() const {
+            return __atomic_load_n(&m_bottom, __ATOMIC_RELAXED) <= __atomic_load_n(&m_top, __ATOMIC_RELAXED);
+        }
+
+        static constexpr size_t capacity() {
+            return SIZE;
+        }
+
+    private:
+        static constexpr s32 MASK = SIZE - 1;
+
+        T m_data[SIZE];
+        s32 m_top;
+        s32 m_bottom;
+    };
+
+}
+
+#endif
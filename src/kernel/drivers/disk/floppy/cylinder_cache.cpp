@@ -0,0 +1,227 @@
+#include "cylinder_cache.hpp"
+#include "data/allocator.hpp"
+#include "data/hash_map.hpp"
+#include "data/intrusive_list.hpp"
+#include "drivers/vga/vga.hpp"
+
+namespace Kernel::FloppyDisk::CylinderCache {
+
+    struct CachedCylinder {
+        u16 key;
+        bool dirty;
+        Data::IntrusiveListNode lruNode;
+        u8 data[CYLINDER_SIZE];
+    };
+
+    static struct {
+        Data::HashMap<u16, CachedCylinder*> index;
+        Data::IntrusiveList<CachedCylinder, &CachedCylinder::lruNode> lru; // most recently used first
+        size_t capacity = DEFAULT_CAPACITY;
+        size_t count = 0;
+        size_t dirtyCount = 0;
+        Statistics statistics = {};
+    } s_cacheState;
+
+    constexpr u16 make_key(u8 t_drive, u8 t_cylinder) {
+        return (static_cast<u16>(t_drive) << 8) | t_cylinder;
+    }
+
+    // Least recently used cylinder that can be dropped, nullptr if every one is dirty
+    static CachedCylinder* get_oldest_clean() {
+        CachedCylinder* cylinder = s_cacheState.lru.back();
+        while (cylinder != nullptr && cylinder->dirty) {
+            cylinder = s_cacheState.lru.previous(*cylinder);
+        }
+        return cylinder;
+    }
+
+    // Cylinders come from the allocator rather than new, so running out of memory fails the insert instead of
+    // stopping the kernel
+    static Data::ErrorOr<CachedCylinder*> create(u16 t_key) {
+        void* memory = TRY(Data::KernelAllocator::allocate(sizeof(CachedCylinder)));
+
+        CachedCylinder* cylinder = new (memory) CachedCylinder;
+        cylinder->key = t_key;
+        cylinder->dirty = false;
+        return cylinder;
+    }
+
+    static void destroy(CachedCylinder* t_cylinder) {
+        t_cylinder->~CachedCylinder();
+        Data::KernelAllocator::deallocate(t_cylinder);
+    }
+
+    static void drop(CachedCylinder* t_cylinder) {
+        (void)s_cacheState.index.remove(t_cylinder->key);
+        s_cacheState.lru.remove(*t_cylinder);
+        s_cacheState.count--;
+
+        destroy(t_cylinder);
+    }
+
+    void set_capacity(size_t t_cylinderCount) {
+        s_cacheState.capacity = t_cylinderCount;
+
+        while (s_cacheState.count > s_cacheState.capacity) {
+            CachedCylinder* cylinder = get_oldest_clean();
+            if (cylinder == nullptr) {
+                break;
+            }
+
+            drop(cylinder);
+            s_cacheState.statistics.evictions++;
+        }
+    }
+
+    size_t get_capacity() {
+        return s_cacheState.capacity;
+    }
+
+    const u8* find(u8 t_drive, u8 t_cylinder) {
+        CachedCylinder** entry = s_cacheState.index.find(make_key(t_drive, t_cylinder));
+        if (entry == nullptr) {
+            s_cacheState.statistics.misses++;
+            return nullptr;
+        }
+
+        CachedCylinder* cylinder = *entry;
+        s_cacheState.lru.remove(*cylinder);
+        s_cacheState.lru.push_front(*cylinder);
+        s_cacheState.statistics.hits++;
+
+        return cylinder->data;
+    }
+
+    bool contains(u8 t_drive, u8 t_cylinder) {
+        return s_cacheState.index.contains(make_key(t_drive, t_cylinder));
+    }
+
+    Data::ErrorOr<void> insert(u8 t_drive, u8 t_cylinder, const u8* t_data) {
+        if (s_cacheState.capacity == 0) {
+            return Data::ErrorOr<void>();
+        }
+
+        const u16 key = make_key(t_drive, t_cylinder);
+        CachedCylinder** existing = s_cacheState.index.find(key);
+
+        CachedCylinder* cylinder;
+        if (existing != nullptr) {
+            cylinder = *existing;
+            if (cylinder->dirty) {
+                return Data::ErrorOr<void>();
+            }
+            s_cacheState.lru.remove(*cylinder);
+        }
+        else if (s_cacheState.count >= s_cacheState.capacity) {
+            // Reuse the least recently used clean cylinder's memory
+            cylinder = get_oldest_clean();
+            ASSERT(cylinder != nullptr, Error::CONTAINER_IS_FULL);
+
+            (void)s_cacheState.index.remove(cylinder->key);
+            s_cacheState.lru.remove(*cylinder);
+            s_cacheState.statistics.evictions++;
+
+            cylinder->key = key;
+            const auto result = s_cacheState.index.set(key, cylinder);
+            if (result.is_error()) {
+                s_cacheState.count--;
+                destroy(cylinder);
+                return result.get_error();
+            }
+        }
+        else {
+            cylinder = TRY(create(key));
+
+            const auto result = s_cacheState.index.set(key, cylinder);
+            if (result.is_error()) {
+                destroy(cylinder);
+                return result.get_error();
+            }
+            s_cacheState.count++;
+        }
+
+        memcpy(cylinder->data, t_data, CYLINDER_SIZE);
+        s_cacheState.lru.push_front(*cylinder);
+
+        return Data::ErrorOr<void>();
+    }
+
+    u8* find_for_write(u8 t_drive, u8 t_cylinder) {
+        CachedCylinder** entry = s_cacheState.index.find(make_key(t_drive, t_cylinder));
+        if (entry == nullptr) {
+            return nullptr;
+        }
+
+        CachedCylinder* cylinder = *entry;
+        s_cacheState.lru.remove(*cylinder);
+        s_cacheState.lru.push_front(*cylinder);
+
+        if (!cylinder->dirty) {
+            cylinder->dirty = true;
+            s_cacheState.dirtyCount++;
+        }
+
+        return cylinder->data;
+    }
+
+    bool get_oldest_dirty(u8& r_drive, u8& r_cylinder, const u8*& r_data) {
+        for (CachedCylinder* cylinder = s_cacheState.lru.back(); cylinder != nullptr; cylinder = s_cacheState.lru.previous(*cylinder)) {
+            if (cylinder->dirty) {
+                r_drive = cylinder->key >> 8;
+                r_cylinder = cylinder->key & 0xFF;
+                r_data = cylinder->data;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void mark_clean(u8 t_drive, u8 t_cylinder) {
+        CachedCylinder** entry = s_cacheState.index.find(make_key(t_drive, t_cylinder));
+        if (entry != nullptr && (*entry)->dirty) {
+            (*entry)->dirty = false;
+            s_cacheState.dirtyCount--;
+        }
+
+        // Catch up on a capacity that was lowered while the cylinder was dirty
+        set_capacity(s_cacheState.capacity);
+    }
+
+    size_t get_dirty_count() {
+        return s_cacheState.dirtyCount;
+    }
+
+    void invalidate(u8 t_drive) {
+        CachedCylinder* cylinder = s_cacheState.lru.front();
+        while (cylinder != nullptr) {
+            CachedCylinder* next = s_cacheState.lru.next(*cylinder);
+            if ((cylinder->key >> 8) == t_drive && !cylinder->dirty) {
+                drop(cylinder);
+            }
+            cylinder = next;
+        }
+    }
+
+    Statistics get_statistics() {
+        return s_cacheState.statistics;
+    }
+
+    void print_statistics() {
+        const Statistics statistics = s_cacheState.statistics;
+
+        VGA::put_string("Floppy cylinder cache\n---------------------\n");
+        VGA::put_unsigned_decimal(s_cacheState.count);
+        VGA::put_string(" of ");
+        VGA::put_unsigned_decimal(s_cacheState.capacity);
+        VGA::put_string(" cylinders cached, ");
+        VGA::put_unsigned_decimal(s_cacheState.dirtyCount);
+        VGA::put_string(" dirty\n");
+        VGA::put_unsigned_decimal(statistics.hits);
+        VGA::put_string(" hits, ");
+        VGA::put_unsigned_decimal(statistics.misses);
+        VGA::put_string(" misses, ");
+        VGA::put_unsigned_decimal(statistics.evictions);
+        VGA::put_string(" evictions\n\n");
+    }
+
+}
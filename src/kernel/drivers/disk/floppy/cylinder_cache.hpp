@@ -0,0 +1,55 @@
+#ifndef FLOPPY_CYLINDER_CACHE_INCLUDED
+#define FLOPPY_CYLINDER_CACHE_INCLUDED
+
+#include "common.hpp"
+#include "data/error_or.hpp"
+#include "floppy.hpp"
+
+namespace Kernel::FloppyDisk::CylinderCache {
+
+    // Whole cylinders (both heads) that have been read recently, so repeated reads are a memcpy instead of a
+    // seek, spin-up and DMA transfer. The least recently used cylinder is dropped when the cache is full.
+    // Writes go into the cached copy and mark it dirty. Dirty cylinders are never dropped, the driver has to
+    // write them back and mark them clean first.
+    // Only the driver touches the cache, with the controller mutex held
+
+    constexpr size_t DEFAULT_CAPACITY = 8; // cylinders, 18KiB each
+
+    struct Statistics {
+        u32 hits;
+        u32 misses;
+        u32 evictions;
+    };
+
+    // Drops clean cylinders until at most t_cylinderCount are cached, 0 turns the cache off
+    void set_capacity(size_t t_cylinderCount);
+    [[nodiscard]] size_t get_capacity();
+
+    // Returns the cached copy of the cylinder and marks it most recently used, nullptr on a miss
+    const u8* find(u8 t_drive, u8 t_cylinder);
+
+    // Like find, but doesn't count as a use
+    [[nodiscard]] bool contains(u8 t_drive, u8 t_cylinder);
+
+    // Copies CYLINDER_SIZE bytes from t_data into the cache, replacing the least recently used clean cylinder if
+    // needed. Fails with CONTAINER_IS_FULL when every cached cylinder is dirty. A dirty copy is newer than t_data
+    // and is kept
+    Data::ErrorOr<void> insert(u8 t_drive, u8 t_cylinder, const u8* t_data);
+
+    // Like find, but marks the cylinder dirty and returns it for writing
+    u8* find_for_write(u8 t_drive, u8 t_cylinder);
+
+    // The least recently used dirty cylinder, false if there is none
+    bool get_oldest_dirty(u8& r_drive, u8& r_cylinder, const u8*& r_data);
+    void mark_clean(u8 t_drive, u8 t_cylinder);
+    [[nodiscard]] size_t get_dirty_count();
+
+    // Forgets every clean cylinder of t_drive, e.g. after a reset. Dirty ones still have to be written
+    void invalidate(u8 t_drive);
+
+    Statistics get_statistics();
+    void print_statistics();
+
+}
+
+#endif
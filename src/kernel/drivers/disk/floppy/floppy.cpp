@@ -2,7 +2,11 @@
 #include "drivers/pit/pit.hpp"
 #include "drivers/vga/vga.hpp"
 #include "floppy.hpp"
-#include "interrupts/pic.hpp"
+#include "cylinder_cache.hpp"
+#include "request_queue.hpp"
+#include "async/event.hpp"
+#include "async/executor.hpp"
+#include "async/mutex.hpp"
 #include "data/error_or.hpp"
 
 namespace Kernel::FloppyDisk {
@@ -44,36 +48,161 @@ namespace Kernel::FloppyDisk {
         COMMAND_SCAN_HIGH_OR_EQUAL = 29
     };
 
+    enum MotorState {
+        MOTOR_OFF,
+        MOTOR_SPINNING_UP,
+        MOTOR_ON,              // in use by the running operation
+        MOTOR_IDLE_PENDING_OFF // still spinning, turned off once it has been idle for s_motorIdleTimeout
+    };
+
+    // Where a drive's heads are before it has been recalibrated, or after a reset or failed seek
+    constexpr u8 UNKNOWN_CYLINDER = 0xFF;
+
+    // ST0 of SENSE INTERRUPT when no drive has a status left, the controller treats the command as invalid
+    constexpr u8 ST0_NOTHING_PENDING = 0x80;
+
+    // RECALIBRATE steps at most 79 times, an 80 cylinder drive may need a second one
+    constexpr size_t RECALIBRATE_ATTEMPT_COUNT = 2;
+
     static volatile struct {
         u8 currentDrive;
-        bool waitingForIRQ;
-        bool diskMotorOn[4];
+        u8 headCylinders[4]; // where each drive's heads are, UNKNOWN_CYLINDER after a reset
+        MotorState motorStates[4];
+        uint lastUsedTicks[4];
+        bool idleTimerRunning[4];
     } s_floppyState;
 
+    static volatile uint s_motorIdleTimeout = DEFAULT_MOTOR_IDLE_TIMEOUT;
+
+    static Async::Event s_irqEvent;
+
+    // A read that starts where the drive's previous one ended is taken as sequential, and the next cylinder
+    // is fetched into the cache in the background while the caller works through this one
+    static struct {
+        size_t nextLba[4];
+        bool pending[4];
+        u32 count;
+    } s_readAheadState;
+
+    // Dirty cylinders are written back by a timer once writes have stopped for WRITE_BACK_DELAY
+    static struct {
+        uint lastWriteTicks;
+        bool timerRunning;
+        u32 cylindersWritten;
+    } s_writeBackState;
+
+    // Reads that went straight into the caller's buffer, and ones that had to go through a DMA buffer
+    static struct {
+        u32 direct;
+        u32 bounced;
+    } s_transferStatistics;
+
+    // Stripes queued at once by read_striped, enough to give every drive work
+    constexpr size_t STRIPE_BATCH_SIZE = 8;
+
+    // Held for a whole public operation, so commands from different callers can't interleave on the controller.
+    // Also covers s_floppyState, the DMA buffer and the parameter/result buffers
+    static Async::Mutex s_controllerMutex("floppy");
+
     constexpr size_t MSR_READ_ATTEMPT_COUNT = 3;
     constexpr size_t COMMAND_ATTEMPT_COUNT = 3;
     constexpr size_t TIMEOUT_TIME = 3 * PIT::TICKS_PER_SECOND;
     constexpr size_t DISK_SPINUP_WAIT_TIME = 300; // 300ms
 
-    constexpr size_t SECTORS_PER_CYLINDER = 18; // TODO: make these dependant on the floppy type
-    constexpr size_t HEAD_COUNT = 2;
+    // Transfer types of the DMA mode register
+    constexpr u8 DMA_TRANSFER_TO_MEMORY = 0b01; // disk reads
+    constexpr u8 DMA_TRANSFER_FROM_MEMORY = 0b10; // disk writes
+
+    // Error bits of the status registers READ DATA and WRITE DATA return
+    constexpr u8 ST0_INTERRUPT_CODE = 0xC0; // 0 on normal termination
+    constexpr u8 ST1_ERRORS = 0x37; // CRC error, overrun, no data, not writable, missing address mark
+    constexpr u8 ST2_ERRORS = 0x33; // CRC error in the data field, wrong cylinder, bad cylinder, missing data address mark
+
+    constexpr size_t SECTORS_PER_WHOLE_CYLINDER = SECTORS_PER_CYLINDER * HEAD_COUNT;
 
-    constexpr size_t DMA_BUFFER_SIZE = 0x4800;
-    static u8 s_dmaBuffer[DMA_BUFFER_SIZE] __attribute__((aligned(0x10000))); // make sure buffer does not cross 64K boundary
+    // Two buffers so multi-cylinder reads can copy one cylinder out while the next one is transferred into the other
+    constexpr size_t DMA_BUFFER_SIZE = CYLINDER_SIZE;
+    constexpr size_t DMA_BUFFER_COUNT = 2;
+    static u8 s_dmaBuffers[DMA_BUFFER_COUNT][DMA_BUFFER_SIZE] __attribute__((aligned(0x10000))); // make sure buffers do not cross 64K boundary
+    static_assert(sizeof(s_dmaBuffers) <= 0x10000, "DMA buffers must fit in one 64K page");
 
     constexpr size_t PARAMETER_BUFFER_SIZE = 16;
     constexpr size_t RESULT_BUFFER_SIZE = 16;
     static u8 s_parameterBytes[PARAMETER_BUFFER_SIZE] = {0};
     static u8 s_resultBytes[RESULT_BUFFER_SIZE] = {0};
 
-    Data::ErrorOr<void> read_cylinder(u8 t_drive, u8 t_cylinder);
+    // A command moves through its phases as the controller gets to them: the command phase writes the command and
+    // parameter bytes, the execution phase runs on the controller until it raises IRQ6, the result phase reads the
+    // result bytes, and completion hands the request to its callback. Commands that don't interrupt go from the
+    // command phase straight to the result. The CPU only touches the controller at the phase changes
+    enum CommandPhase {
+        PHASE_IDLE,
+        PHASE_COMMAND,
+        PHASE_EXECUTION,
+        PHASE_RESULT,
+        PHASE_COMPLETE
+    };
+
+    struct CommandRequest;
+    using CommandCallback = void (*)(CommandRequest& t_request, void* t_context);
 
-    Data::ErrorOr<void> send_command(Command t_command);
+    struct CommandRequest {
+        Command command;
+        u8 parameters[PARAMETER_BUFFER_SIZE];
+        u8 results[RESULT_BUFFER_SIZE];
+        volatile CommandPhase phase;
+        Data::ErrorOr<void> result;
+
+        // Called once the command is complete, from the IRQ handler if it has an execution phase
+        CommandCallback callback;
+        void* context;
+    };
 
-    Data::ErrorOr<void> select_drive(u8 t_drive, bool t_motorOn);
+    // The command in its execution phase, the IRQ handler takes it from here. Other IRQs (reset, overlapped seeks)
+    // go to s_irqEvent
+    static CommandRequest* volatile s_activeCommand = nullptr;
+
+    Async::Task<void> initialize_controller();
+    Async::Task<void> reset_controller(u8 t_drive, bool t_motorOn);
+    Async::Task<void> read_sectors(u8 t_drive, size_t t_lba, size_t t_count, bool t_sequential, u8* r_buffer);
+
+    Async::Task<void> read_cylinder(u8 t_drive, u8 t_cylinder, u8* r_buffer);
+    Async::Task<void> read_chs(u8 t_drive, u8 t_cylinder, u8 t_head, u8 t_sector, size_t t_count, u8* r_buffer);
+    Async::Task<void> write_chs(u8 t_drive, u8 t_cylinder, u8 t_head, u8 t_sector, size_t t_count, const u8* t_buffer);
+    Async::Task<void> transfer_chs(Command t_command, u8 t_drive, u8 t_cylinder, u8 t_head, u8 t_sector, size_t t_count, u8* t_buffer);
+
+    Async::Task<void> write_sectors(u8 t_drive, size_t t_lba, size_t t_count, const u8* t_buffer);
+
+    Async::Task<void> submit_request(RequestQueue::Request& t_request);
+    Async::Task<void> dispatch_requests();
+    Async::Task<void> seek_ahead(const RequestQueue::Request& t_request);
+    Async::Task<void> seek_drives(const u8* t_cylinders, u8 t_driveMask);
+    Async::Task<void> perform_read(const RequestQueue::Request& t_request);
+    Async::Task<void> perform_write(const RequestQueue::Request& t_request);
+    Async::Task<void> write_back_oldest();
+    Async::Task<void> flush_all();
+    Async::Task<void> flush_when_idle();
+    void start_write_back_timer();
+    Async::Task<void> read_ahead(u8 t_drive, u8 t_cylinder);
+    void start_read_ahead(u8 t_drive, size_t t_endLba);
+    Async::Task<const u8*> get_sectors(u8 t_drive, size_t t_lba, size_t t_count, bool t_sequential, u8* r_destination, u8* r_bounceBuffer);
+
+    Async::Task<void> send_command(Command t_command);
+    Data::ErrorOr<void> submit_command(CommandRequest& t_request);
+    void read_command_result(CommandRequest& t_request);
+    void complete_command(CommandRequest& t_request, Data::ErrorOr<void> t_result);
+    bool cancel_command(CommandRequest& t_request);
+    void signal_command_event(CommandRequest& t_request, void* t_context);
+    Data::ErrorOr<void> write_command_bytes(Command t_command, const u8* t_parameters);
+
+    Async::Task<void> select_drive(u8 t_drive, bool t_motorOn);
+    Async::Task<void> recalibrate(u8 t_drive);
+    void release_motor(u8 t_drive);
+    Async::Task<void> turn_off_idle_motor(u8 t_drive);
+    void write_digital_output();
 
     Data::ErrorOr<u8> read_msr_until_rqm();
-    Data::ErrorOr<void> wait_for_irq();
+    Async::Event::WaitAwaiter wait_for_irq();
 
     struct CHSAddress {
         u8 c, h, s;
@@ -87,6 +216,12 @@ namespace Kernel::FloppyDisk {
         return CHSAddress{cylinder, head, sector};
     }
 
+    // Sectors from t_lba up to t_endLba or the end of t_lba's cylinder, whichever comes first
+    constexpr size_t get_segment_length(size_t t_lba, size_t t_endLba) {
+        const size_t remainingInCylinder = SECTORS_PER_WHOLE_CYLINDER - (t_lba % SECTORS_PER_WHOLE_CYLINDER);
+        return (t_endLba - t_lba < remainingInCylinder) ? (t_endLba - t_lba) : remainingInCylinder;
+    }
+
     // Base Case
     template <size_t T_index=0>
     void set_parameters() {
@@ -103,17 +238,9 @@ namespace Kernel::FloppyDisk {
     }
 
     template <typename ...Ts>
-    Data::ErrorOr<void> execute_command(Command t_command, Ts... t_parameters) {
+    Async::Task<void> execute_command(Command t_command, Ts... t_parameters) {
         set_parameters(t_parameters...);
-
-        for (size_t i = 0; i < COMMAND_ATTEMPT_COUNT; i++) {
-            const auto result = send_command(t_command);
-            if (!result.is_error()) {
-                return Data::ErrorOr<void>();
-            }
-        }
-
-        return Error::TIMED_OUT;
+        co_return co_await send_command(t_command);
     }
 
     constexpr size_t get_parameter_count(Command t_command) {
@@ -223,93 +350,540 @@ namespace Kernel::FloppyDisk {
             (t_command == COMMAND_SEEK); // TODO: make sure all commands are included here!
     }
 
+    Async::Task<void> initialize_async() {
+        const auto guard = co_await s_controllerMutex.lock();
+        const auto result = co_await initialize_controller();
+        release_motor(s_floppyState.currentDrive);
+        co_return result;
+    }
+
+    Async::Task<void> reset_async(u8 t_drive, bool t_motorOn) {
+        const auto guard = co_await s_controllerMutex.lock();
+        const auto result = co_await reset_controller(t_drive, t_motorOn);
+        release_motor(t_drive);
+        co_return result;
+    }
+
+    Async::Task<void> read_data_async(u8 t_drive, size_t t_lba, size_t t_count, u8* r_buffer) {
+        CO_ASSERT(t_drive < 4, Error::INDEX_OUT_OF_RANGE);
+
+        RequestQueue::Request request;
+        request.drive = t_drive;
+        request.write = false;
+        request.lba = t_lba;
+        request.count = t_count;
+        request.buffer = r_buffer;
+
+        co_return co_await submit_request(request);
+    }
+
+    Async::Task<void> write_data_async(u8 t_drive, size_t t_lba, size_t t_count, const u8* t_buffer) {
+        CO_ASSERT(t_drive < 4, Error::INDEX_OUT_OF_RANGE);
+
+        RequestQueue::Request request;
+        request.drive = t_drive;
+        request.write = true;
+        request.lba = t_lba;
+        request.count = t_count;
+        request.buffer = const_cast<u8*>(t_buffer);
+
+        co_return co_await submit_request(request);
+    }
+
+    Async::Task<void> read_striped_async(u8 t_driveCount, size_t t_lba, size_t t_count, u8* r_buffer) {
+        CO_ASSERT(t_driveCount >= 1 && t_driveCount <= 4, Error::INVALID_ARGUMENT);
+        CO_ASSERT(t_count > 0, Error::INVALID_ARGUMENT);
+        CO_ASSERT(t_lba + t_count <= t_driveCount * CYLINDER_COUNT * SECTORS_PER_WHOLE_CYLINDER, Error::INDEX_OUT_OF_RANGE);
+
+        size_t lba = t_lba;
+        const size_t endLba = t_lba + t_count;
+        RequestQueue::Request requests[STRIPE_BATCH_SIZE];
+
+        while (lba < endLba) {
+            // Queue a whole batch before the dispatcher starts, so it sees work for every drive and can overlap their seeks
+            size_t batchCount = 0;
+            bool startDispatcher = false;
+            for (; batchCount < STRIPE_BATCH_SIZE && lba < endLba; batchCount++) {
+                const size_t sectorCount = get_segment_length(lba, endLba);
+                const size_t logicalCylinder = lba / SECTORS_PER_WHOLE_CYLINDER;
+
+                RequestQueue::Request& request = requests[batchCount];
+                request.drive = logicalCylinder % t_driveCount;
+                request.write = false;
+                request.lba = (logicalCylinder / t_driveCount) * SECTORS_PER_WHOLE_CYLINDER + lba % SECTORS_PER_WHOLE_CYLINDER;
+                request.count = sectorCount;
+                request.buffer = r_buffer;
+                startDispatcher |= RequestQueue::push(request);
+
+                r_buffer += sectorCount * SECTOR_SIZE;
+                lba += sectorCount;
+            }
+
+            if (startDispatcher) {
+                Async::spawn(dispatch_requests());
+            }
+
+            // Every request has to finish before its memory goes away, even if an earlier one failed
+            Data::ErrorOr<void> result;
+            for (size_t i = 0; i < batchCount; i++) {
+                (void)co_await requests[i].done.wait();
+                if (requests[i].result.is_error()) {
+                    result = requests[i].result;
+                }
+            }
+            CO_TRY(result);
+        }
+
+        co_return Data::ErrorOr<void>();
+    }
+
+    // t_request lives in the caller's frame until it completes
+    Async::Task<void> submit_request(RequestQueue::Request& t_request) {
+        if (RequestQueue::push(t_request)) {
+            Async::spawn(dispatch_requests());
+        }
+
+        CO_TRY(co_await t_request.done.wait());
+        co_return t_request.result;
+    }
+
+    // Reads and writes go through the request queue, one dispatcher runs them while any are pending. The controller
+    // mutex is taken per request, so read-aheads, write-backs and the motor timers get their turn in between
+    Async::Task<void> dispatch_requests() {
+        while (true) {
+            const auto guard = co_await s_controllerMutex.lock();
+
+            // Once this comes back empty the queue counts the dispatcher as stopped, the next push starts another one
+            RequestQueue::Request* request = RequestQueue::pop_next();
+            if (request == nullptr) {
+                break;
+            }
+
+            // A failed seek is left to the implied seek of the transfer to retry
+            (void)co_await seek_ahead(*request);
+
+            Data::ErrorOr<void> result;
+            if (request->write) {
+                result = co_await perform_write(*request);
+            }
+            else {
+                result = co_await perform_read(*request);
+            }
+            RequestQueue::complete(*request, result);
+        }
+
+        co_return Data::ErrorOr<void>();
+    }
+
+    // Moves the heads of t_request's drive and of every other drive with a request waiting into place together,
+    // so their seeks overlap instead of each one waiting for the transfer before it
+    Async::Task<void> seek_ahead(const RequestQueue::Request& t_request) {
+        u8 cylinders[4];
+        u8 driveMask = 0;
+        size_t driveCount = 0;
+
+        for (u8 drive = 0; drive < 4; drive++) {
+            size_t lba = t_request.lba;
+            if (drive != t_request.drive) {
+                const RequestQueue::Request* next = RequestQueue::peek_drive(drive);
+                if (next == nullptr) {
+                    continue;
+                }
+                lba = next->lba;
+            }
+
+            if (lba >= CYLINDER_COUNT * SECTORS_PER_WHOLE_CYLINDER) {
+                continue;
+            }
+
+            const u8 cylinder = lba_to_chs(lba).c;
+            if (cylinder != s_floppyState.headCylinders[drive] && !CylinderCache::contains(drive, cylinder)) {
+                cylinders[drive] = cylinder;
+                driveMask |= 1 << drive;
+                driveCount++;
+            }
+        }
+
+        // One drive on its own is left to the implied seek of its transfer
+        if (driveCount < 2) {
+            co_return Data::ErrorOr<void>();
+        }
+
+        co_return co_await seek_drives(cylinders, driveMask);
+    }
+
+    Async::Task<void> perform_read(const RequestQueue::Request& t_request) {
+        const bool sequential = t_request.sequential || (t_request.lba == s_readAheadState.nextLba[t_request.drive]);
+        const auto result = co_await read_sectors(t_request.drive, t_request.lba, t_request.count, sequential, t_request.buffer);
+        release_motor(t_request.drive);
+        CO_TRY(result);
+
+        s_readAheadState.nextLba[t_request.drive] = t_request.lba + t_request.count;
+        if (sequential) {
+            // The read-ahead queues up on the mutex, so it starts as soon as this request is done
+            start_read_ahead(t_request.drive, t_request.lba + t_request.count);
+        }
+
+        co_return Data::ErrorOr<void>();
+    }
+
+    Async::Task<void> perform_write(const RequestQueue::Request& t_request) {
+        const auto result = co_await write_sectors(t_request.drive, t_request.lba, t_request.count, t_request.buffer);
+        release_motor(t_request.drive);
+        start_write_back_timer();
+
+        co_return result;
+    }
+
+    Async::Task<void> flush_async() {
+        const auto guard = co_await s_controllerMutex.lock();
+        co_return co_await flush_all();
+    }
+
+    void set_motor_idle_timeout(uint t_ticks) {
+        s_motorIdleTimeout = t_ticks;
+    }
+
+    void print_cache_statistics() {
+        CylinderCache::print_statistics();
+
+        VGA::put_unsigned_decimal(s_readAheadState.count);
+        VGA::put_string(" cylinders read ahead, ");
+        VGA::put_unsigned_decimal(s_writeBackState.cylindersWritten);
+        VGA::put_string(" written back\n");
+
+        VGA::put_unsigned_decimal(s_transferStatistics.direct);
+        VGA::put_string(" direct reads, ");
+        VGA::put_unsigned_decimal(s_transferStatistics.bounced);
+        VGA::put_string(" through a DMA buffer\n\n");
+    }
+
+    void print_queue_statistics() {
+        RequestQueue::print_statistics();
+    }
+
     Data::ErrorOr<void> initialize() {
+        return Async::block_on(initialize_async());
+    }
+
+    Data::ErrorOr<void> reset(u8 t_drive, bool t_motorOn) {
+        return Async::block_on(reset_async(t_drive, t_motorOn));
+    }
+
+    Data::ErrorOr<void> read_data(u8 t_drive, size_t t_lba, size_t t_count, u8* r_buffer) {
+        return Async::block_on(read_data_async(t_drive, t_lba, t_count, r_buffer));
+    }
+
+    Data::ErrorOr<void> write_data(u8 t_drive, size_t t_lba, size_t t_count, const u8* t_buffer) {
+        return Async::block_on(write_data_async(t_drive, t_lba, t_count, t_buffer));
+    }
+
+    Data::ErrorOr<void> flush() {
+        return Async::block_on(flush_async());
+    }
+
+    Data::ErrorOr<void> read_striped(u8 t_driveCount, size_t t_lba, size_t t_count, u8* r_buffer) {
+        return Async::block_on(read_striped_async(t_driveCount, t_lba, t_count, r_buffer));
+    }
+
+    Async::Task<void> initialize_controller() {
         s_floppyState.currentDrive = 0;
-        s_floppyState.waitingForIRQ = false;
         for (size_t i = 0; i < 4; i++) {
-            s_floppyState.diskMotorOn[i] = false;
+            s_floppyState.motorStates[i] = MOTOR_OFF;
+            s_floppyState.headCylinders[i] = UNKNOWN_CYLINDER;
         }
 
-        TRY(execute_command(COMMAND_VERSION));
-        ASSERT(s_resultBytes[0] == 0x90, Error::NOT_IMPLEMENTED); // TODO: possibly implement other versions
+        CO_TRY(co_await execute_command(COMMAND_VERSION));
+        CO_ASSERT(s_resultBytes[0] == 0x90, Error::NOT_IMPLEMENTED); // TODO: possibly implement other versions
 
-        TRY(execute_command(COMMAND_CONFIGURE, 0x00, 0x57, 0x00)); // Implied seek on, FIFO on, drive polling mode off, threshold = 8 (7 + 1)
-        TRY(execute_command(COMMAND_LOCK));
-        TRY(reset(0, true));
+        CO_TRY(co_await execute_command(COMMAND_CONFIGURE, 0x00, 0x57, 0x00)); // Implied seek on, FIFO on, drive polling mode off, threshold = 8 (7 + 1)
+        CO_TRY(co_await execute_command(COMMAND_LOCK));
+        CO_TRY(co_await reset_controller(0, true));
 
-        TRY(execute_command(COMMAND_VERSION)); // TODO: figure out why this helps (disk change flag gets cleared?)
+        CO_TRY(co_await execute_command(COMMAND_VERSION)); // TODO: figure out why this helps (disk change flag gets cleared?)
 
-        TRY(execute_command(COMMAND_RECALIBRATE, 0));
-        TRY(execute_command(COMMAND_SENSE_INTERRUPT));
+        CO_TRY(co_await recalibrate(0));
 
-        TRY(DMA::initialize_channel(2, s_dmaBuffer, DMA_BUFFER_SIZE - 1)); // set-up DMA on channel 2 (floppy disk channel)
-
-        return Data::ErrorOr<void>();
+        co_return Data::ErrorOr<void>();
     }
 
-    Data::ErrorOr<void> reset(u8 t_drive, bool t_motorOn) {
-        s_floppyState.waitingForIRQ = true; // Set state to be ready for a reset IRQ
+    Async::Task<void> reset_controller(u8 t_drive, bool t_motorOn) {
+        // A reset is how errors are recovered from, don't trust what was read before it
+        CylinderCache::invalidate(t_drive);
+        for (size_t i = 0; i < 4; i++) {
+            s_floppyState.headCylinders[i] = UNKNOWN_CYLINDER;
+        }
+
+        s_irqEvent.reset(); // Set state to be ready for a reset IRQ
         port_write_byte(DATARATE_SELECT_REGISTER, 0x80);
 
-        TRY(wait_for_irq());
+        CO_TRY(co_await wait_for_irq());
 
-        TRY(select_drive(t_drive, t_motorOn));
+        CO_TRY(co_await select_drive(t_drive, t_motorOn));
 
-        return Data::ErrorOr<void>();
+        co_return Data::ErrorOr<void>();
     }
 
-    Data::ErrorOr<void> read_data(u8 t_drive, size_t t_lba, size_t t_count, u8* r_buffer) {
-        ASSERT(t_count > 0, Error::INVALID_ARGUMENT);
+    Async::Task<void> read_sectors(u8 t_drive, size_t t_lba, size_t t_count, bool t_sequential, u8* r_buffer) {
+        CO_ASSERT(t_count > 0, Error::INVALID_ARGUMENT);
+        CO_ASSERT(t_lba + t_count <= CYLINDER_COUNT * SECTORS_PER_WHOLE_CYLINDER, Error::INDEX_OUT_OF_RANGE);
+
+        // Copy the requested part of each cylinder the range touches, unless it was read straight into r_buffer.
+        // Tasks run until they first suspend, so the next cylinder's read is already on its way while this one is copied
+        size_t lba = t_lba;
+        const size_t endLba = t_lba + t_count;
+        size_t bufferIndex = 0;
+        Async::Task<const u8*> pending = get_sectors(t_drive, lba, get_segment_length(lba, endLba), t_sequential, r_buffer, s_dmaBuffers[bufferIndex]);
+
+        while (lba < endLba) {
+            CO_TRY_ASSIGN(const u8* data, co_await pending);
+
+            const size_t sectorCount = get_segment_length(lba, endLba);
+            const size_t nextLba = lba + sectorCount;
 
-        const CHSAddress startAddress = lba_to_chs(t_lba);
-        const CHSAddress endAddress = lba_to_chs(t_lba + t_count);
+            // data stays valid until pending is awaited, nothing gets cached or evicted before then
+            if (nextLba < endLba) {
+                bufferIndex = (bufferIndex + 1) % DMA_BUFFER_COUNT;
+                u8* nextDestination = r_buffer + sectorCount * SECTOR_SIZE;
+                pending = get_sectors(t_drive, nextLba, get_segment_length(nextLba, endLba), t_sequential, nextDestination, s_dmaBuffers[bufferIndex]);
+            }
+
+            if (data != r_buffer) {
+                memcpy(r_buffer, data, sectorCount * SECTOR_SIZE);
+            }
+            r_buffer += sectorCount * SECTOR_SIZE;
+            lba = nextLba;
+        }
 
-        const auto get_next_cylinder = [](CHSAddress t_address) -> CHSAddress {
-            t_address.c++;
-            t_address.h = 0;
-            t_address.s = 0;
-            return t_address;
-        };
+        co_return Data::ErrorOr<void>();
+    }
 
-        CHSAddress currentAddress = startAddress;
-        for (; currentAddress.c != endAddress.c; currentAddress = get_next_cylinder(currentAddress)) {
-            TRY(read_cylinder(t_drive, currentAddress.c));
+    // Returns the data of t_count sectors starting at t_lba, all on one cylinder. They come from the cache if it
+    // has the cylinder. Otherwise a sequential reader gets the whole cylinder read and cached, since it will want
+    // the rest soon, and anyone else gets exactly the sectors asked for.
+    // When the transfer is exactly the sectors asked for and r_destination is in reach of the DMA controller it
+    // goes straight there, otherwise into r_bounceBuffer (one of the DMA buffers)
+    Async::Task<const u8*> get_sectors(u8 t_drive, size_t t_lba, size_t t_count, bool t_sequential, u8* r_destination, u8* r_bounceBuffer) {
+        const CHSAddress address = lba_to_chs(t_lba);
+        const size_t firstSector = t_lba % SECTORS_PER_WHOLE_CYLINDER;
+
+        const u8* cached = CylinderCache::find(t_drive, address.c);
+        if (cached != nullptr) {
+            co_return cached + firstSector * SECTOR_SIZE;
+        }
 
-            const size_t sectorIndex = (currentAddress.h * SECTORS_PER_CYLINDER) + (currentAddress.s - 1);
+        const bool wholeCylinder = (t_count == SECTORS_PER_WHOLE_CYLINDER) || (t_sequential && CylinderCache::get_capacity() != 0);
+        const size_t transferCount = wholeCylinder ? SECTORS_PER_WHOLE_CYLINDER : t_count;
 
-            const size_t offset = sectorIndex * SECTOR_SIZE;
-            const size_t byteCount = (SECTORS_PER_CYLINDER - sectorIndex - 1) * SECTOR_SIZE;
+        u8* buffer = r_bounceBuffer;
+        if (transferCount == t_count && DMA::can_transfer(r_destination, transferCount * SECTOR_SIZE)) {
+            buffer = r_destination;
+            s_transferStatistics.direct++;
+        }
+        else {
+            s_transferStatistics.bounced++;
+        }
 
-            memcpy(r_buffer, s_dmaBuffer + offset, byteCount);
-            r_buffer += byteCount;
+        if (!wholeCylinder) {
+            CO_TRY(co_await read_chs(t_drive, address.c, address.h, address.s, t_count, buffer));
+            co_return static_cast<const u8*>(buffer);
         }
 
-        if (endAddress.h != 0 || endAddress.s != 0) {
-            TRY(read_cylinder(t_drive, currentAddress.c));
+        CO_TRY(co_await read_cylinder(t_drive, address.c, buffer));
 
-            const size_t startSectorIndex = (currentAddress.h * SECTORS_PER_CYLINDER) + (currentAddress.s - 1);
-            const size_t endSectorIndex = (endAddress.h * SECTORS_PER_CYLINDER) + (endAddress.s - 1);
+        // Not being able to cache it doesn't stop this read
+        (void)CylinderCache::insert(t_drive, address.c, buffer);
 
-            const size_t offset = startSectorIndex * SECTOR_SIZE;
-            const size_t byteCount = (endSectorIndex - startSectorIndex) * SECTOR_SIZE;
+        co_return static_cast<const u8*>(buffer + firstSector * SECTOR_SIZE);
+    }
 
-            memcpy(r_buffer, s_dmaBuffer + offset, byteCount);
+    void start_read_ahead(u8 t_drive, size_t t_endLba) {
+        const size_t nextCylinder = (t_endLba - 1) / SECTORS_PER_WHOLE_CYLINDER + 1;
+        if (s_readAheadState.pending[t_drive] || nextCylinder >= CYLINDER_COUNT || CylinderCache::get_capacity() == 0) {
+            return;
         }
 
-        return Data::ErrorOr<void>();
+        s_readAheadState.pending[t_drive] = true;
+        Async::spawn(read_ahead(t_drive, nextCylinder));
+    }
+
+    Async::Task<void> read_ahead(u8 t_drive, u8 t_cylinder) {
+        const auto guard = co_await s_controllerMutex.lock();
+        s_readAheadState.pending[t_drive] = false;
+
+        if (!CylinderCache::contains(t_drive, t_cylinder)) {
+            // Errors are left for the real read of the cylinder to report
+            const auto result = co_await read_cylinder(t_drive, t_cylinder, s_dmaBuffers[0]);
+            if (!result.is_error() && !CylinderCache::insert(t_drive, t_cylinder, s_dmaBuffers[0]).is_error()) {
+                s_readAheadState.count++;
+            }
+            release_motor(t_drive);
+        }
+
+        co_return Data::ErrorOr<void>();
+    }
+
+    // Writes into the cached copy of each cylinder the range touches, reading the cylinder first unless it is
+    // overwritten completely. Only if the cache is off do the sectors go straight to the disk
+    Async::Task<void> write_sectors(u8 t_drive, size_t t_lba, size_t t_count, const u8* t_buffer) {
+        CO_ASSERT(t_count > 0, Error::INVALID_ARGUMENT);
+        CO_ASSERT(t_lba + t_count <= CYLINDER_COUNT * SECTORS_PER_WHOLE_CYLINDER, Error::INDEX_OUT_OF_RANGE);
+
+        size_t lba = t_lba;
+        const size_t endLba = t_lba + t_count;
+        while (lba < endLba) {
+            const CHSAddress address = lba_to_chs(lba);
+            const size_t firstSector = lba % SECTORS_PER_WHOLE_CYLINDER;
+            const size_t sectorCount = get_segment_length(lba, endLba);
+
+            u8* cached = CylinderCache::find_for_write(t_drive, address.c);
+            bool alreadyCopied = false;
+            if (cached == nullptr && CylinderCache::get_capacity() != 0) {
+                // The cylinder needs a clean one to replace
+                if (CylinderCache::get_dirty_count() >= CylinderCache::get_capacity()) {
+                    CO_TRY(co_await write_back_oldest());
+                }
+
+                const u8* data = t_buffer;
+                if (sectorCount != SECTORS_PER_WHOLE_CYLINDER) {
+                    CO_TRY(co_await read_cylinder(t_drive, address.c, s_dmaBuffers[0]));
+                    data = s_dmaBuffers[0];
+                }
+
+                if (!CylinderCache::insert(t_drive, address.c, data).is_error()) {
+                    cached = CylinderCache::find_for_write(t_drive, address.c);
+                    alreadyCopied = (data == t_buffer);
+                }
+            }
+
+            if (cached != nullptr) {
+                if (!alreadyCopied) {
+                    memcpy(cached + firstSector * SECTOR_SIZE, t_buffer, sectorCount * SECTOR_SIZE);
+                }
+            }
+            else {
+                const u8* data = t_buffer;
+                if (!DMA::can_transfer(t_buffer, sectorCount * SECTOR_SIZE)) {
+                    memcpy(s_dmaBuffers[0], t_buffer, sectorCount * SECTOR_SIZE);
+                    data = s_dmaBuffers[0];
+                }
+                CO_TRY(co_await write_chs(t_drive, address.c, address.h, address.s, sectorCount, data));
+            }
+
+            t_buffer += sectorCount * SECTOR_SIZE;
+            lba += sectorCount;
+        }
+
+        co_return Data::ErrorOr<void>();
     }
 
-    Data::ErrorOr<void> read_cylinder(u8 t_drive, u8 t_cylinder) {
-        TRY(select_drive(t_drive, true));
+    // Writes the least recently used dirty cylinder back to the disk in one transfer
+    Async::Task<void> write_back_oldest() {
+        u8 drive;
+        u8 cylinder;
+        const u8* data;
+        if (!CylinderCache::get_oldest_dirty(drive, cylinder, data)) {
+            co_return Data::ErrorOr<void>();
+        }
 
-        TRY(DMA::set_mode(2, 0b10, true, false, 0b01)); // prepare DMA channel for reading
+        if (!DMA::can_transfer(data, CYLINDER_SIZE)) {
+            memcpy(s_dmaBuffers[0], data, CYLINDER_SIZE);
+            data = s_dmaBuffers[0];
+        }
+
+        // The cylinder can be on another drive than the one the caller releases, so this releases its own
+        const Data::ErrorOr<void> result = co_await write_chs(drive, cylinder, 0, 1, SECTORS_PER_WHOLE_CYLINDER, data);
+        release_motor(drive);
+        CO_TRY(result);
+
+        CylinderCache::mark_clean(drive, cylinder);
+        s_writeBackState.cylindersWritten++;
+
+        co_return Data::ErrorOr<void>();
+    }
 
-        TRY(execute_command(
-                COMMAND_READ_DATA,
-                (0 << 2) | s_floppyState.currentDrive,
+    Async::Task<void> flush_all() {
+        Data::ErrorOr<void> result;
+        while (CylinderCache::get_dirty_count() != 0) {
+            result = co_await write_back_oldest();
+            if (result.is_error()) {
+                break;
+            }
+        }
+
+        for (u8 drive = 0; drive < 4; drive++) {
+            release_motor(drive);
+        }
+
+        co_return result;
+    }
+
+    void start_write_back_timer() {
+        s_writeBackState.lastWriteTicks = PIT::get_ticks();
+
+        if (!s_writeBackState.timerRunning && CylinderCache::get_dirty_count() != 0) {
+            s_writeBackState.timerRunning = true;
+            Async::spawn(flush_when_idle());
+        }
+    }
+
+    Async::Task<void> flush_when_idle() {
+        Data::ErrorOr<void> result;
+
+        while (true) {
+            const uint idleTime = PIT::get_ticks() - s_writeBackState.lastWriteTicks;
+            if (idleTime < WRITE_BACK_DELAY) {
+                co_await Async::sleep_for(WRITE_BACK_DELAY - idleTime);
+                continue;
+            }
+
+            // Writes that came in while this waited for the controller push the flush back. The flag is cleared
+            // with the mutex still held, so a write right after this can't find it set and skip starting a timer
+            const auto guard = co_await s_controllerMutex.lock();
+            if (PIT::get_ticks() - s_writeBackState.lastWriteTicks >= WRITE_BACK_DELAY) {
+                result = co_await flush_all();
+                s_writeBackState.timerRunning = false;
+                break;
+            }
+        }
+
+        co_return result;
+    }
+
+    Async::Task<void> read_cylinder(u8 t_drive, u8 t_cylinder, u8* r_buffer) {
+        co_return co_await read_chs(t_drive, t_cylinder, 0, 1, SECTORS_PER_WHOLE_CYLINDER, r_buffer);
+    }
+
+    // Reads t_count sectors from (t_cylinder, t_head, t_sector) on, which must all be on t_cylinder. With the MT bit set
+    // the controller carries on from the end of head 0 onto head 1, and the DMA terminal count stops the command
+    // right after the last sector asked for
+    Async::Task<void> read_chs(u8 t_drive, u8 t_cylinder, u8 t_head, u8 t_sector, size_t t_count, u8* r_buffer) {
+        co_return co_await transfer_chs(COMMAND_READ_DATA, t_drive, t_cylinder, t_head, t_sector, t_count, r_buffer);
+    }
+
+    Async::Task<void> write_chs(u8 t_drive, u8 t_cylinder, u8 t_head, u8 t_sector, size_t t_count, const u8* t_buffer) {
+        co_return co_await transfer_chs(COMMAND_WRITE_DATA, t_drive, t_cylinder, t_head, t_sector, t_count, const_cast<u8*>(t_buffer));
+    }
+
+    // READ DATA or WRITE DATA between t_buffer and the sectors, see read_chs
+    Async::Task<void> transfer_chs(Command t_command, u8 t_drive, u8 t_cylinder, u8 t_head, u8 t_sector, size_t t_count, u8* t_buffer) {
+        CO_ASSERT(t_count > 0 && (t_head * SECTORS_PER_CYLINDER + t_sector - 1) + t_count <= SECTORS_PER_WHOLE_CYLINDER, Error::INVALID_ARGUMENT);
+
+        CO_TRY(co_await select_drive(t_drive, true));
+        if (s_floppyState.headCylinders[t_drive] == UNKNOWN_CYLINDER) {
+            CO_TRY(co_await recalibrate(t_drive));
+        }
+
+        const u8 transferType = (t_command == COMMAND_WRITE_DATA) ? DMA_TRANSFER_FROM_MEMORY : DMA_TRANSFER_TO_MEMORY;
+        CO_TRY(DMA::initialize_channel(2, t_buffer, t_count * SECTOR_SIZE - 1)); // point DMA channel 2 (floppy disk channel) at the buffer
+        CO_TRY(DMA::set_mode(2, transferType, true, false, 0b01)); // prepare DMA channel for the transfer direction
+
+        CO_TRY(co_await execute_command(
+                t_command,
+                (t_head << 2) | s_floppyState.currentDrive,
                 t_cylinder,
-                0,
-                1,
+                t_head,
+                t_sector,
                 2,
                 SECTORS_PER_CYLINDER,
                 0x1B,
@@ -317,66 +891,355 @@ namespace Kernel::FloppyDisk {
             )
         );
 
+        // Anything but a normal termination (e.g. a CRC error or a write protected disk) means the data didn't make
+        // it, and a read must not hand out whatever was left in the buffer
+        CO_ASSERT((s_resultBytes[0] & ST0_INTERRUPT_CODE) == 0, Error::DRIVER_COMMAND_FAILED);
+        CO_ASSERT((s_resultBytes[1] & ST1_ERRORS) == 0, Error::DRIVER_COMMAND_FAILED);
+        CO_ASSERT((s_resultBytes[2] & ST2_ERRORS) == 0, Error::DRIVER_COMMAND_FAILED);
+
+        s_floppyState.headCylinders[t_drive] = t_cylinder;
+
+        co_return Data::ErrorOr<void>();
+    }
+
+    // Starts a SEEK on every drive in t_driveMask, then waits until all of them are done. The controller only takes
+    // more SEEKs while drives are stepping, not transfers, so the heads travel together and the transfers follow
+    Async::Task<void> seek_drives(const u8* t_cylinders, u8 t_driveMask) {
+        // Spin up every motor that is needed with a single wait
+        bool spinUp = false;
+        for (u8 drive = 0; drive < 4; drive++) {
+            if ((t_driveMask & (1 << drive)) == 0) {
+                continue;
+            }
+
+            if (s_floppyState.motorStates[drive] == MOTOR_OFF || s_floppyState.motorStates[drive] == MOTOR_SPINNING_UP) {
+                s_floppyState.motorStates[drive] = MOTOR_SPINNING_UP;
+                spinUp = true;
+            }
+            else {
+                s_floppyState.motorStates[drive] = MOTOR_ON;
+            }
+        }
+
+        write_digital_output();
+        if (spinUp) {
+            co_await Async::sleep_for(DISK_SPINUP_WAIT_TIME);
+        }
+
+        Data::ErrorOr<void> result;
+        for (u8 drive = 0; drive < 4; drive++) {
+            if ((t_driveMask & (1 << drive)) != 0) {
+                s_floppyState.motorStates[drive] = MOTOR_ON;
+            }
+        }
+
+        // A drive's SEEK only lands on the right cylinder once the controller knows where its heads are. This goes
+        // first, its SENSE INTERRUPT would otherwise take the status of a drive that is seeking
+        for (u8 drive = 0; drive < 4 && !result.is_error(); drive++) {
+            if ((t_driveMask & (1 << drive)) != 0 && s_floppyState.headCylinders[drive] == UNKNOWN_CYLINDER) {
+                result = co_await select_drive(drive, true);
+                if (!result.is_error()) {
+                    result = co_await recalibrate(drive);
+                }
+            }
+        }
+
+        // Every SEEK interrupts, including the ones that finish before the last one is started
+        s_irqEvent.reset();
+
+        u8 seeking = 0;
+        for (u8 drive = 0; drive < 4 && !result.is_error(); drive++) {
+            if ((t_driveMask & (1 << drive)) == 0) {
+                continue;
+            }
+
+            set_parameters((0 << 2) | drive, t_cylinders[drive]);
+            result = write_command_bytes(COMMAND_SEEK, s_parameterBytes);
+            if (result.is_error()) {
+                break;
+            }
+
+            s_floppyState.headCylinders[drive] = UNKNOWN_CYLINDER;
+            seeking |= 1 << drive;
+        }
+
+        // Every drive that has finished has a status waiting for SENSE INTERRUPT, and its busy bit in the MSR stays
+        // set until it is taken. More than one may be behind a single IRQ, so after each one the statuses are taken
+        // until the controller has none left. ST0 names the drive each one belongs to
+        while (seeking != 0 && !result.is_error()) {
+            result = co_await wait_for_irq();
+            s_irqEvent.reset();
+
+            while (!result.is_error()) {
+                result = co_await execute_command(COMMAND_SENSE_INTERRUPT);
+                if (result.is_error() || s_resultBytes[0] == ST0_NOTHING_PENDING) {
+                    break;
+                }
+
+                const u8 drive = s_resultBytes[0] & 0x03;
+                seeking &= ~(1 << drive);
+                if ((s_resultBytes[0] & 0xE0) == 0x20) { // seek end, normal termination
+                    s_floppyState.headCylinders[drive] = s_resultBytes[1];
+                }
+            }
+        }
+
+        for (u8 drive = 0; drive < 4; drive++) {
+            if ((t_driveMask & (1 << drive)) != 0) {
+                release_motor(drive);
+            }
+        }
+
+        co_return result;
+    }
+
+    // Runs t_command with the parameters in s_parameterBytes and leaves its result bytes in s_resultBytes.
+    // Only a refused command byte is tried again: nothing has happened on the disk at that point. Once the
+    // controller took the command byte it is waiting for parameters, so a resubmitted command byte would be read
+    // as one and the controller needs a reset. A command that ran and failed is up to the caller to recover from
+    Async::Task<void> send_command(Command t_command) {
+        Async::Event completed;
+
+        CommandRequest request;
+        request.command = t_command;
+        memcpy(request.parameters, s_parameterBytes, PARAMETER_BUFFER_SIZE);
+        request.callback = signal_command_event;
+        request.context = &completed;
+
+        Data::ErrorOr<void> submitted = submit_command(request);
+        for (size_t i = 1; i < COMMAND_ATTEMPT_COUNT && submitted.is_error() && submitted.get_error() == Error::DRIVER_COMMAND_REFUSED; i++) {
+            submitted = submit_command(request);
+        }
+        CO_TRY(submitted);
+
+        const auto waited = co_await completed.wait(TIMEOUT_TIME);
+
+        // The request lives in this frame, the IRQ handler must be done with it before it goes away
+        if (waited.is_error() && cancel_command(request)) {
+            co_return Error::TIMED_OUT;
+        }
+
+        memcpy(s_resultBytes, request.results, RESULT_BUFFER_SIZE);
+        co_return request.result;
+    }
+
+    // Starts t_request's command phase. On success the request will be completed through its callback, possibly
+    // before this returns. On DRIVER_COMMAND_REFUSED the controller didn't take the command byte and the request can
+    // be submitted again, on any other error the controller is stuck partway through the command
+    Data::ErrorOr<void> submit_command(CommandRequest& t_request) {
+        ASSERT(s_activeCommand == nullptr, Error::DRIVER_COMMAND_FAILED);
+
+        t_request.phase = PHASE_COMMAND;
+        const bool hasInterrupt = command_has_interrupt(t_request.command);
+
+        // The IRQ can come as soon as the last parameter byte is written, the handler has to find the request by then
+        const u32 flags = save_and_disable_interrupts();
+
+        const auto written = write_command_bytes(t_request.command, t_request.parameters);
+        if (written.is_error()) {
+            t_request.phase = PHASE_IDLE;
+            restore_interrupts(flags);
+            return written.get_error();
+        }
+
+        if (hasInterrupt) {
+            t_request.phase = PHASE_EXECUTION;
+            s_activeCommand = &t_request;
+        }
+
+        restore_interrupts(flags);
+
+        if (!hasInterrupt) {
+            read_command_result(t_request);
+        }
+
         return Data::ErrorOr<void>();
     }
 
-    Data::ErrorOr<void> send_command(Command t_command) {
+    // Result phase, from the IRQ handler once the execution phase is over or straight after the command phase
+    void read_command_result(CommandRequest& t_request) {
+        t_request.phase = PHASE_RESULT;
+
+        const size_t resultByteCount = get_result_byte_count(t_request.command);
+        for (size_t i = 0; i < resultByteCount; i++) {
+            t_request.results[i] = port_read_byte(DATA_FIFO);
+
+            const auto msr = read_msr_until_rqm();
+            if (msr.is_error()) {
+                complete_command(t_request, msr.get_error());
+                return;
+            }
+
+            // An invalid command, e.g. SENSE INTERRUPT with no status pending, only returns ST0 = 0x80
+            if (i == 0 && t_request.results[0] == ST0_NOTHING_PENDING && (msr.get_value() & 0x50) == 0x00) {
+                break;
+            }
+
+            // More result bytes to come, or back to waiting for a command after the last one
+            const u8 expected = (i + 1 < resultByteCount) ? 0x50 : 0x00;
+            if ((msr.get_value() & 0x50) != expected) {
+                complete_command(t_request, Error::DRIVER_COMMAND_FAILED);
+                return;
+            }
+        }
+
+        complete_command(t_request, Data::ErrorOr<void>());
+    }
+
+    void complete_command(CommandRequest& t_request, Data::ErrorOr<void> t_result) {
+        t_request.result = t_result;
+        t_request.phase = PHASE_COMPLETE;
+
+        t_request.callback(t_request, t_request.context);
+    }
+
+    // Stops waiting for t_request's IRQ, false if it completed after all
+    bool cancel_command(CommandRequest& t_request) {
+        const u32 flags = save_and_disable_interrupts();
+
+        if (s_activeCommand == &t_request) {
+            s_activeCommand = nullptr;
+        }
+        const bool cancelled = (t_request.phase != PHASE_COMPLETE);
+
+        restore_interrupts(flags);
+
+        return cancelled;
+    }
+
+    void signal_command_event(CommandRequest& t_request, void* t_context) {
+        (void)t_request;
+        static_cast<Async::Event*>(t_context)->signal();
+    }
+
+    // Command and parameter phase, the caller deals with the IRQ and result bytes. DRIVER_COMMAND_REFUSED if the
+    // controller wasn't ready for the command byte, DRIVER_DEVICE_NEEDS_RESET if it stopped taking parameters
+    Data::ErrorOr<void> write_command_bytes(Command t_command, const u8* t_parameters) {
         // Send command byte
         u8 msr = port_read_byte(MAIN_STATUS_REGISTER);
-        ASSERT((msr & 0xc0) == 0x80, Error::DRIVER_DEVICE_NEEDS_RESET); // Check that RQM = 1 and DIO = 0
+        ASSERT((msr & 0xc0) == 0x80, Error::DRIVER_COMMAND_REFUSED); // Check that RQM = 1 and DIO = 0
 
         port_write_byte(DATA_FIFO, t_command); // TODO: add check that command is valid
 
         // Send parameter bytes
-        if (command_has_interrupt(t_command)) {
-            s_floppyState.waitingForIRQ = true;
+        for (size_t i = 0; i < get_parameter_count(t_command); i++) {
+            const auto ready = read_msr_until_rqm();
+            ASSERT(!ready.is_error(), Error::DRIVER_DEVICE_NEEDS_RESET);
+            msr = ready.get_value();
+            ASSERT((msr & 0xc0) == 0x80, Error::DRIVER_DEVICE_NEEDS_RESET);
+
+            port_write_byte(DATA_FIFO, t_parameters[i]);
         }
 
-        for (size_t i = 0; i < get_parameter_count(t_command); i++) {
-            msr = TRY(read_msr_until_rqm());
-            ASSERT((msr & 0xc0) == 0x80, Error::DRIVER_COMMAND_FAILED);
+        return Data::ErrorOr<void>();
+    }
 
-            port_write_byte(DATA_FIFO, s_parameterBytes[i]);
+    Async::Task<void> select_drive(u8 t_drive, bool t_motorOn) {
+        CO_ASSERT(t_drive < 4, Error::INDEX_OUT_OF_RANGE);
+
+        if (s_floppyState.currentDrive != t_drive) {
+            port_write_byte(CONFIGURATION_CONTROL_REGISTER, 0); // set to 0 for 1.44MiB floppy
+            CO_TRY(co_await execute_command(COMMAND_SPECIFY, (8 << 4) | 0, (5 << 1) | 0)); // SRT=8ms, HLT=10ms, HUT=0ms, NDMA=0 (using DMA)
         }
 
-        if (command_has_interrupt(t_command)) {
-            TRY(wait_for_irq());
+        const bool driveChanged = (s_floppyState.currentDrive != t_drive);
+        s_floppyState.currentDrive = t_drive;
+
+        if (!t_motorOn) {
+            s_floppyState.motorStates[t_drive] = MOTOR_OFF;
+            write_digital_output();
+            co_return Data::ErrorOr<void>();
         }
 
-        // Receive result bytes
-        const size_t resultByteCount = get_result_byte_count(t_command);
-        if (resultByteCount != 0) {
-            for (size_t i = 0; i < resultByteCount - 1; i++) {
-                s_resultBytes[i] = port_read_byte(DATA_FIFO);
-                msr = TRY(read_msr_until_rqm());
-                ASSERT((msr & 0x50) == 0x50, Error::DRIVER_COMMAND_FAILED);
+        // A motor that is still spinning from an earlier operation is ready straight away
+        if (s_floppyState.motorStates[t_drive] == MOTOR_ON || s_floppyState.motorStates[t_drive] == MOTOR_IDLE_PENDING_OFF) {
+            s_floppyState.motorStates[t_drive] = MOTOR_ON;
+            if (driveChanged) {
+                write_digital_output();
             }
+            co_return Data::ErrorOr<void>();
+        }
+
+        s_floppyState.motorStates[t_drive] = MOTOR_SPINNING_UP;
+        write_digital_output();
+
+        co_await Async::sleep_for(DISK_SPINUP_WAIT_TIME); // wait for disk to spin up
+
+        s_floppyState.motorStates[t_drive] = MOTOR_ON;
+
+        co_return Data::ErrorOr<void>();
+    }
 
-            s_resultBytes[resultByteCount - 1] = port_read_byte(DATA_FIFO);
-            msr = TRY(read_msr_until_rqm());
-            ASSERT((msr & 0x50) == 0x00, Error::DRIVER_COMMAND_FAILED);
+    // Moves t_drive's heads to cylinder 0, so the controller knows where they are. The drive must be selected with
+    // its motor on
+    Async::Task<void> recalibrate(u8 t_drive) {
+        for (size_t i = 0; i < RECALIBRATE_ATTEMPT_COUNT; i++) {
+            CO_TRY(co_await execute_command(COMMAND_RECALIBRATE, t_drive));
+            CO_TRY(co_await execute_command(COMMAND_SENSE_INTERRUPT));
+
+            if ((s_resultBytes[0] & 0xE0) == 0x20 && s_resultBytes[1] == 0) { // seek end, normal termination
+                s_floppyState.headCylinders[t_drive] = 0;
+                co_return Data::ErrorOr<void>();
+            }
         }
 
-        return Data::ErrorOr<void>();
+        co_return Error::DRIVER_COMMAND_FAILED;
     }
 
-    Data::ErrorOr<void> select_drive(u8 t_drive, bool t_motorOn) {
-        ASSERT(t_drive < 4, Error::INDEX_OUT_OF_RANGE);
+    // Called with the controller mutex held once an operation is done with the drive. The motor keeps
+    // spinning in case another operation follows, and is turned off after s_motorIdleTimeout without one
+    void release_motor(u8 t_drive) {
+        if (s_floppyState.motorStates[t_drive] != MOTOR_ON) {
+            return;
+        }
 
-        if (s_floppyState.currentDrive != t_drive) {
-            port_write_byte(CONFIGURATION_CONTROL_REGISTER, 0); // set to 0 for 1.44MiB floppy
-            TRY(execute_command(COMMAND_SPECIFY, (8 << 4) | 0, (5 << 1) | 0)); // SRT=8ms, HLT=10ms, HUT=0ms, NDMA=0 (using DMA)
+        s_floppyState.motorStates[t_drive] = MOTOR_IDLE_PENDING_OFF;
+        s_floppyState.lastUsedTicks[t_drive] = PIT::get_ticks();
+
+        // One timer per drive, it keeps going for as long as the drive keeps being used
+        if (!s_floppyState.idleTimerRunning[t_drive]) {
+            s_floppyState.idleTimerRunning[t_drive] = true;
+            Async::spawn(turn_off_idle_motor(t_drive));
         }
-        if (s_floppyState.currentDrive != t_drive || s_floppyState.diskMotorOn[t_drive] != t_motorOn) {
-            port_write_byte(DIGITAL_OUTPUT_REGISTER, ((!!t_motorOn) << (4 + t_drive)) | (0x0C | t_drive));
+    }
+
+    Async::Task<void> turn_off_idle_motor(u8 t_drive) {
+        while (true) {
+            const uint timeout = s_motorIdleTimeout;
+            const uint idleTime = PIT::get_ticks() - s_floppyState.lastUsedTicks[t_drive];
+            if (idleTime < timeout) {
+                co_await Async::sleep_for(timeout - idleTime);
+                continue;
+            }
+
+            // The drive may have been used while this waited for the controller. The flag is cleared with the
+            // mutex still held, otherwise release_motor could see it set and not start a new timer
+            const auto guard = co_await s_controllerMutex.lock();
+            if (s_floppyState.motorStates[t_drive] != MOTOR_IDLE_PENDING_OFF) {
+                s_floppyState.idleTimerRunning[t_drive] = false;
+                break;
+            }
+            if (PIT::get_ticks() - s_floppyState.lastUsedTicks[t_drive] >= s_motorIdleTimeout) {
+                s_floppyState.motorStates[t_drive] = MOTOR_OFF;
+                write_digital_output();
+                s_floppyState.idleTimerRunning[t_drive] = false;
+                break;
+            }
         }
 
-        s_floppyState.currentDrive = t_drive;
-        s_floppyState.diskMotorOn[t_drive] = t_motorOn;
+        co_return Data::ErrorOr<void>();
+    }
 
-        sleep(DISK_SPINUP_WAIT_TIME); // wait for disk to spin up
+    // Selects the current drive and turns on the motor of every drive that should be spinning
+    void write_digital_output() {
+        u8 value = 0x0C | s_floppyState.currentDrive; // not in reset, IRQ and DMA enabled
+        for (size_t i = 0; i < 4; i++) {
+            if (s_floppyState.motorStates[i] != MOTOR_OFF) {
+                value |= 1 << (4 + i);
+            }
+        }
 
-        return Data::ErrorOr<void>();
+        port_write_byte(DIGITAL_OUTPUT_REGISTER, value);
     }
 
     Data::ErrorOr<u8> read_msr_until_rqm() {
@@ -390,23 +1253,22 @@ namespace Kernel::FloppyDisk {
         return Error::RETRY_LIMIT_REACHED;
     }
 
-    Data::ErrorOr<void> wait_for_irq() {
-        const uint start = PIT::get_ticks();
-
-        while (PIT::get_ticks() - start < TIMEOUT_TIME) {
-            if (!s_floppyState.waitingForIRQ) {
-                return Data::ErrorOr<void>();
-            }
-            KERNEL_HALT();
-        }
-
-        return Error::TIMED_OUT;
+    Async::Event::WaitAwaiter wait_for_irq() {
+        return s_irqEvent.wait(TIMEOUT_TIME);
     }
 
-    void floppy_handler(InterruptHandler::InterruptFrame* t_frame) {
+    void floppy_handler(void* t_context) {
+        (void)t_context;
         // VGA::put_string("IRQ6 Called\n");
-        s_floppyState.waitingForIRQ = false;
-        PIC::send_end_of_interrupt(0);
+
+        CommandRequest* command = s_activeCommand;
+        if (command != nullptr) {
+            s_activeCommand = nullptr;
+            read_command_result(*command);
+            return;
+        }
+
+        s_irqEvent.signal();
     }
 
 }
@@ -2,20 +2,57 @@
 #define FLOPPY_DISK_INCLUDED
 
 #include "common.hpp"
+#include "async/task.hpp"
 #include "data/error_or.hpp"
-#include "interrupts/interrupt_handler.hpp"
 
 namespace Kernel::FloppyDisk {
 
     // TODO: move this into floppy_disk.cpp
     constexpr size_t SECTOR_SIZE = 512;
-    
+
+    constexpr size_t SECTORS_PER_CYLINDER = 18; // TODO: make these dependant on the floppy type
+    constexpr size_t HEAD_COUNT = 2;
+    constexpr size_t CYLINDER_COUNT = 80;
+
+    // Both heads of one cylinder, what a single multi-track READ DATA transfers
+    constexpr size_t CYLINDER_SIZE = SECTORS_PER_CYLINDER * HEAD_COUNT * SECTOR_SIZE;
+
+    // The commands run as coroutines on the async executor, the plain versions block the calling thread until they finish
+    Async::Task<void> initialize_async();
+    Async::Task<void> reset_async(u8 t_drive, bool t_motorOn);
+
+    Async::Task<void> read_data_async(u8 t_drive, size_t t_lba, size_t t_count, u8* r_buffer);
+    Async::Task<void> write_data_async(u8 t_drive, size_t t_lba, size_t t_count, const u8* t_buffer);
+    Async::Task<void> flush_async();
+
     Data::ErrorOr<void> initialize();
     Data::ErrorOr<void> reset(u8 t_drive, bool t_motorOn);
 
     Data::ErrorOr<void> read_data(u8 t_drive, size_t t_lba, size_t t_count, u8* r_buffer);
 
-    INTERRUPT_HANDLER void floppy_handler(InterruptHandler::InterruptFrame* t_frame);
+    // Writes land in the cylinder cache and reach the disk a whole cylinder at a time, when a cylinder has to make
+    // room, on flush, or once nothing has been written for WRITE_BACK_DELAY
+    Data::ErrorOr<void> write_data(u8 t_drive, size_t t_lba, size_t t_count, const u8* t_buffer);
+    Data::ErrorOr<void> flush();
+
+    // Reads from a volume striped over drives 0 to t_driveCount - 1 a cylinder at a time: logical cylinder k is
+    // cylinder k / t_driveCount of drive k % t_driveCount. The drives seek in parallel
+    Async::Task<void> read_striped_async(u8 t_driveCount, size_t t_lba, size_t t_count, u8* r_buffer);
+    Data::ErrorOr<void> read_striped(u8 t_driveCount, size_t t_lba, size_t t_count, u8* r_buffer);
+
+    constexpr uint WRITE_BACK_DELAY = 1000; // 1s
+
+    // How long a drive's motor keeps spinning after its last operation, so back-to-back operations don't wait for it to spin up again
+    constexpr uint DEFAULT_MOTOR_IDLE_TIMEOUT = 2 * 1000; // 2s
+    void set_motor_idle_timeout(uint t_ticks);
+
+    // Counters of the cylinder cache, the read-ahead and how reads reached the caller
+    void print_cache_statistics();
+
+    // Request count, seek distance and latency of the request queue
+    void print_queue_statistics();
+
+    void floppy_handler(void* t_context);
 }
 
 #endif
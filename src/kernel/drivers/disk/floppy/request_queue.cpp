@@ -0,0 +1,147 @@
+#include "request_queue.hpp"
+#include "floppy.hpp"
+#include "drivers/pit/pit.hpp"
+#include "drivers/vga/vga.hpp"
+#include "sync/spinlock.hpp"
+
+namespace Kernel::FloppyDisk::RequestQueue {
+
+    // Orders requests by drive, then LBA
+    constexpr u32 get_position(u8 t_drive, size_t t_lba) {
+        return (static_cast<u32>(t_drive) << 24) | static_cast<u32>(t_lba);
+    }
+
+    struct PositionOrder {
+        static bool less(const Request& t_a, const Request& t_b) {
+            return get_position(t_a.drive, t_a.lba) < get_position(t_b.drive, t_b.lba);
+        }
+
+        static bool less(const Request& t_request, const u32& t_position) {
+            return get_position(t_request.drive, t_request.lba) < t_position;
+        }
+    };
+
+    static struct {
+        Data::RBTree<Request, &Request::node, PositionOrder> pending;
+        u32 headPosition = 0; // where the last request handed out ends
+        size_t lastCylinder[4] = {};
+        Statistics statistics = {};
+        bool dispatcherRunning = false;
+    } s_queueState;
+
+    static Sync::IRQSpinLock s_queueLock("floppy queue");
+
+    static bool continues(const Request& t_first, const Request& t_second) {
+        return t_first.drive == t_second.drive && t_first.write == t_second.write && t_first.lba + t_first.count == t_second.lba;
+    }
+
+    static size_t get_cylinder(size_t t_lba) {
+        return t_lba / (SECTORS_PER_CYLINDER * HEAD_COUNT);
+    }
+
+    bool push(Request& t_request) {
+        t_request.sequential = false;
+        t_request.submitTicks = PIT::get_ticks();
+        t_request.done.reset();
+
+        Sync::LockGuard guard(s_queueLock);
+        s_queueState.pending.insert(t_request);
+
+        const bool startDispatcher = !s_queueState.dispatcherRunning;
+        s_queueState.dispatcherRunning = true;
+        return startDispatcher;
+    }
+
+    Request* pop_next() {
+        Sync::LockGuard guard(s_queueLock);
+
+        Request* request = s_queueState.pending.lower_bound(s_queueState.headPosition);
+        if (request == nullptr) {
+            request = s_queueState.pending.first();
+        }
+        if (request == nullptr) {
+            s_queueState.dispatcherRunning = false;
+            return nullptr;
+        }
+
+        Request* next = s_queueState.pending.next(*request);
+        s_queueState.pending.remove(*request);
+
+        // Adjacent requests are served back to back, the first one fetches whole cylinders for the rest
+        const bool merged = request->sequential;
+        if (next != nullptr && continues(*request, *next)) {
+            request->sequential = true;
+            next->sequential = true;
+        }
+        if (merged) {
+            s_queueState.statistics.merged++;
+        }
+
+        const size_t cylinder = get_cylinder(request->lba);
+        const size_t lastCylinder = s_queueState.lastCylinder[request->drive];
+        s_queueState.statistics.seekDistance += (cylinder > lastCylinder) ? (cylinder - lastCylinder) : (lastCylinder - cylinder);
+        s_queueState.lastCylinder[request->drive] = get_cylinder(request->lba + request->count - 1);
+
+        s_queueState.headPosition = get_position(request->drive, request->lba + request->count);
+
+        return request;
+    }
+
+    Request* peek_drive(u8 t_drive) {
+        Sync::LockGuard guard(s_queueLock);
+
+        const size_t lastLba = s_queueState.lastCylinder[t_drive] * SECTORS_PER_CYLINDER * HEAD_COUNT;
+
+        Request* request = s_queueState.pending.lower_bound(get_position(t_drive, lastLba));
+        if (request == nullptr || request->drive != t_drive) {
+            request = s_queueState.pending.lower_bound(get_position(t_drive, 0));
+        }
+
+        return (request != nullptr && request->drive == t_drive) ? request : nullptr;
+    }
+
+    bool is_empty() {
+        Sync::LockGuard guard(s_queueLock);
+        return s_queueState.pending.is_empty();
+    }
+
+    void complete(Request& t_request, Data::ErrorOr<void> t_result) {
+        const uint latency = PIT::get_ticks() - t_request.submitTicks;
+
+        Statistics& statistics = s_queueState.statistics;
+        statistics.completed++;
+        statistics.lastLatency = latency;
+        statistics.totalLatency += latency;
+        if (latency > statistics.maxLatency) {
+            statistics.maxLatency = latency;
+        }
+
+        t_request.result = t_result;
+        t_request.done.signal();
+    }
+
+    Statistics get_statistics() {
+        return s_queueState.statistics;
+    }
+
+    void print_statistics() {
+        const Statistics statistics = s_queueState.statistics;
+
+        VGA::put_string("Floppy request queue\n--------------------\n");
+        VGA::put_unsigned_decimal(statistics.completed);
+        VGA::put_string(" requests, ");
+        VGA::put_unsigned_decimal(statistics.merged);
+        VGA::put_string(" merged, ");
+        VGA::put_unsigned_decimal(statistics.seekDistance);
+        VGA::put_string(" cylinders seeked\n");
+
+        VGA::put_string("Latency (ticks): last ");
+        VGA::put_unsigned_decimal(statistics.lastLatency);
+        VGA::put_string(", average ");
+        VGA::put_unsigned_decimal((statistics.completed == 0) ? 0 : statistics.totalLatency / statistics.completed);
+        VGA::put_string(", max ");
+        VGA::put_unsigned_decimal(statistics.maxLatency);
+        VGA::put_string("\n\n");
+    }
+
+}
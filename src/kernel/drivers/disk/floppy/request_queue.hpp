@@ -0,0 +1,65 @@
+#ifndef FLOPPY_REQUEST_QUEUE_INCLUDED
+#define FLOPPY_REQUEST_QUEUE_INCLUDED
+
+#include "common.hpp"
+#include "async/event.hpp"
+#include "data/error_or.hpp"
+#include "data/rb_tree.hpp"
+
+namespace Kernel::FloppyDisk::RequestQueue {
+
+    // Reads and writes waiting for the controller, sorted by drive and LBA. They are handed out in one upward
+    // sweep from where the last request ended, jumping back to the lowest one once nothing is left above it
+    // (C-LOOK), so concurrent readers don't make the heads seek back and forth.
+    // Callers push from their own threads while the dispatcher pops on the executor, so the queue is guarded by
+    // a spin lock. The same lock covers whether a dispatcher is running, so a request can't be pushed after the
+    // dispatcher found the queue empty but before it stopped, and then never be popped
+
+    struct Request {
+        u8 drive;
+        bool write;
+        size_t lba;
+        size_t count;
+        u8* buffer; // only read from for writes
+
+        // Set by pop_next when a neighbouring request continues where this one ends (or the other way round),
+        // the driver then reads whole cylinders so they share one transfer through the cache
+        bool sequential;
+
+        uint submitTicks;
+        Data::ErrorOr<void> result;
+        Async::Event done;
+
+        Data::RBTreeNode node;
+    };
+
+    struct Statistics {
+        u32 completed;
+        u32 merged;        // requests that continued the one before them
+        u32 seekDistance;  // cylinders the heads moved between requests
+        uint lastLatency;  // ticks from push to complete
+        uint maxLatency;
+        uint totalLatency;
+    };
+
+    // Returns true if no dispatcher is running, the caller has to start one then. It is counted as running from here
+    [[nodiscard]] bool push(Request& t_request);
+
+    // Takes the next request in C-LOOK order. nullptr if none are pending, the dispatcher then counts as stopped and
+    // must return
+    Request* pop_next();
+
+    // The request pop_next would take next for t_drive alone, without taking it. nullptr if the drive has none
+    Request* peek_drive(u8 t_drive);
+
+    [[nodiscard]] bool is_empty();
+
+    // Records the request's latency and wakes whoever is waiting on it, t_request must not be touched afterwards
+    void complete(Request& t_request, Data::ErrorOr<void> t_result);
+
+    Statistics get_statistics();
+    void print_statistics();
+
+}
+
+#endif
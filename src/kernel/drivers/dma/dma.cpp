@@ -131,6 +131,13 @@ namespace Kernel::DMA {
         return Data::ErrorOr<void>();
     }
 
+    bool can_transfer(const void* t_buffer, size_t t_size) {
+        const uintptr_t start = reinterpret_cast<uintptr_t>(t_buffer);
+        const uintptr_t last = start + t_size - 1;
+
+        return t_size != 0 && last >= start && last < 0x1000000 && (start >> 16) == (last >> 16);
+    }
+
     Data::ErrorOr<void> set_mode(u8 t_channel, u8 t_transferType, bool t_autoInit, bool t_down, u8 t_mode) {
         const u8 channelMaskPort = TRY(get_single_channel_mask(t_channel));
         const u8 modePort = TRY(get_mode(t_channel));
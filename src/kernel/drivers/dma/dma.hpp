@@ -7,6 +7,9 @@
 namespace Kernel::DMA {
 
     Data::ErrorOr<void> initialize_channel(u8 t_channel, void* t_bufferAddress, u16 t_count);
+    // ISA DMA only reaches the first 16MiB and a transfer can't cross a 64K boundary
+    bool can_transfer(const void* t_buffer, size_t t_size);
+
     Data::ErrorOr<void> set_mode(u8 t_channel, u8 t_transferType, bool t_autoInit, bool t_down, u8 t_mode);
 
 }
@@ -1,6 +1,5 @@
 #include "common.hpp"
 #include "pit.hpp"
-#include "interrupts/pic.hpp"
 
 #include "drivers/vga/vga.hpp"
 
@@ -65,9 +64,9 @@ namespace Kernel::PIT {
         return s_ticks;
     }
 
-    INTERRUPT_HANDLER void interval_handler(InterruptHandler::InterruptFrame* t_frame) {
+    void interval_handler(void* t_context) {
+        (void)t_context;
         s_ticks++;
-        PIC::send_end_of_interrupt(0x20);
     }
 
 }
@@ -2,7 +2,6 @@
 #define PIT_INCLUDED
 
 #include "common.hpp"
-#include "interrupts/interrupt_handler.hpp"
 
 namespace Kernel::PIT {
     
@@ -19,7 +18,7 @@ namespace Kernel::PIT {
 
     constexpr uint TICKS_PER_SECOND = 1000; // TODO: handle this better
 
-    INTERRUPT_HANDLER void interval_handler(InterruptHandler::InterruptFrame* t_frame);
+    void interval_handler(void* t_context);
 
 }
 
@@ -1,6 +1,6 @@
 #include "common.hpp"
-#include "data/queue.hpp"
-#include "interrupts/pic.hpp"
+#include "data/spsc_ring.hpp"
+#include "interrupts/softirq.hpp"
 
 #include "drivers/ps2/ps2.hpp"
 #include "keyboard.hpp"
@@ -9,10 +9,22 @@
 namespace Kernel::PS2::Keyboard {
     
     constexpr uint SEND_COMMAND_RETRY_LIMIT = 3;
-    constexpr size_t KEYBOARD_EVENT_QUEUE_SIZE = 32;
+    constexpr size_t KEYBOARD_EVENT_QUEUE_SIZE = 32; // must be a power of two
+
+    constexpr u8 DATA_PORT = 0x60;
+    constexpr u8 STATUS_REGISTER_PORT = 0x64;
 
     static bool KEYBOARD_KEY_STATE[256] = {0};
-    static Data::Queue<KeyboardEvent, KEYBOARD_EVENT_QUEUE_SIZE> KEYBOARD_EVENT_QUEUE;
+    static Data::SPSCRing<KeyboardEvent, KEYBOARD_EVENT_QUEUE_SIZE> KEYBOARD_EVENT_QUEUE; // filled by the soft IRQ, drained by poll_event
+
+    enum class ParseState {
+        BEGIN,
+        E0,
+        F0,
+        E0_F0
+    };
+
+    static ParseState s_parseState = ParseState::BEGIN;
 
     enum Command : u8 {
         COMMAND_ENABLE_SCANNING = 0xF4,
@@ -28,7 +40,10 @@ namespace Kernel::PS2::Keyboard {
     // Send command until an response isn't a resend or the attempt limit is reached
     Data::ErrorOr<u8> resend_until_success_or_timeout(u8 t_command);
 
-    Keycode parse_scancode(KeyEvent& r_event);
+    // Feeds one scancode byte into the parser, returns KEYCODE_UNKNOWN until a full sequence has been received
+    Keycode parse_scancode(u8 t_byte, KeyEvent& r_event);
+
+    void process_scancode_byte(u32 t_byte);
     
     constexpr bool is_keyboard(DeviceType t_type) {
         return (
@@ -59,7 +74,7 @@ namespace Kernel::PS2::Keyboard {
     }
 
     Data::ErrorOr<KeyboardEvent> poll_event() {
-        return KEYBOARD_EVENT_QUEUE.pop_front();
+        return KEYBOARD_EVENT_QUEUE.pop();
     }
 
     Data::ErrorOr<u8> resend_until_success_or_timeout(u8 t_command) {
@@ -75,7 +90,7 @@ namespace Kernel::PS2::Keyboard {
         return Error::RETRY_LIMIT_REACHED;
     }
 
-    Keycode parse_scancode(KeyEvent& r_event) {
+    Keycode parse_scancode(u8 t_byte, KeyEvent& r_event) {
         constexpr Keycode SCANCODE_MAP_SINGLE_BYTE[256] = {
             KEYCODE_UNKNOWN, /* 0x00 */
             KEYCODE_F9, /* 0x01 */
@@ -594,81 +609,63 @@ namespace Kernel::PS2::Keyboard {
             KEYCODE_UNKNOWN, /* 0xff */
         };
 
-        enum class ParseState {
-            BEGIN,
-            E0,
-            E012
-        };
-
-        const auto get_response_unsafe = []() -> u8 {
-            for (size_t i = 0; i < SEND_COMMAND_RETRY_LIMIT; i++) {
-                if (port_read_byte(0x64) & 0x01) {
-                    return port_read_byte(0x60);
+        switch (s_parseState) {
+            case ParseState::BEGIN:
+                if (t_byte == 0xE0) {
+                    s_parseState = ParseState::E0;
+                    return KEYCODE_UNKNOWN;
+                }
+                else if (t_byte == 0xF0) {
+                    s_parseState = ParseState::F0;
+                    return KEYCODE_UNKNOWN;
                 }
-                io_wait();
-            }
-            return 0x00;
-        };
-
-        const u8 b1 = get_response_unsafe();
-        if (b1 == 0xE0) {
-            const u8 b2 = get_response_unsafe();
 
-            // unimplemented
-            if (b2 == 0x12) {
-                while (get_response_unsafe() != 0x00) {}
                 r_event = KeyEvent::PRESSED;
-                return KEYCODE_UNKNOWN;
-            }
-            else if (b2 == 0xF0) {
-                const u8 b3 = get_response_unsafe();
-
-                // unimplemented
-                if (b2 == 0x12) {
-                    while (get_response_unsafe() != 0x00) {}
-                    r_event = KeyEvent::PRESSED;
+                return SCANCODE_MAP_SINGLE_BYTE[t_byte];
+            case ParseState::F0:
+                s_parseState = ParseState::BEGIN;
+                r_event = KeyEvent::RELEASED;
+                return SCANCODE_MAP_SINGLE_BYTE[t_byte];
+            case ParseState::E0:
+                if (t_byte == 0xF0) {
+                    s_parseState = ParseState::E0_F0;
                     return KEYCODE_UNKNOWN;
                 }
-                else {
-                    r_event = KeyEvent::RELEASED;
-                    return SCANCODE_MAP_E0[b3];
-                }
-            }
-            else {
+
+                // E0 12 is the fake shift sent around print screen (unimplemented), E0 7C maps to KEYCODE_UNKNOWN
+                s_parseState = ParseState::BEGIN;
                 r_event = KeyEvent::PRESSED;
-                return SCANCODE_MAP_E0[b2];
-            }
-        }
-        else if (b1 == 0xF0) {
-            const u8 b2 = get_response_unsafe();
-            r_event = KeyEvent::RELEASED;
-            return SCANCODE_MAP_SINGLE_BYTE[b2];
+                return SCANCODE_MAP_E0[t_byte];
+            case ParseState::E0_F0:
+                s_parseState = ParseState::BEGIN;
+                r_event = KeyEvent::RELEASED;
+                return SCANCODE_MAP_E0[t_byte];
         }
-        else {
-            r_event = KeyEvent::PRESSED;
-            return SCANCODE_MAP_SINGLE_BYTE[b1];
-        }
-        
+
+        return KEYCODE_UNKNOWN;
     }
 
     bool is_key_pressed(Keycode t_key) {
         return KEYBOARD_KEY_STATE[t_key];
     }
 
-    INTERRUPT_HANDLER void keyboard_handler(InterruptHandler::InterruptFrame* t_frame) {
+    void process_scancode_byte(u32 t_byte) {
         KeyEvent event = KeyEvent::PRESSED;
-        const Keycode keycode = parse_scancode(event);
+        const Keycode keycode = parse_scancode(static_cast<u8>(t_byte), event);
 
         if (keycode != KEYCODE_UNKNOWN) {
-            // compiler complains without this being in a lambda
-            [&](){
-                KEYBOARD_EVENT_QUEUE.push_back({keycode, event});
-            }();
             KEYBOARD_KEY_STATE[keycode] = (event == KeyEvent::PRESSED);
+            (void)KEYBOARD_EVENT_QUEUE.push({keycode, event});
         }
+    }
+
+    void keyboard_handler(void* t_context) {
+        (void)t_context;
 
-        // Acknowledge interrupt
-        PIC::send_end_of_interrupt(0x21);
+        // Only fetch the byte here, the table walk and queue push run later with interrupts enabled
+        if (port_read_byte(STATUS_REGISTER_PORT) & 0x01) {
+            SoftIRQ::raise(process_scancode_byte, port_read_byte(DATA_PORT));
+        }
     }
 
 }
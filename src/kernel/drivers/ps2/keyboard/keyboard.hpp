@@ -507,7 +507,7 @@ namespace Kernel::PS2::Keyboard {
 
     bool is_key_pressed(Keycode t_key);
 
-    INTERRUPT_HANDLER void keyboard_handler(InterruptHandler::InterruptFrame* t_frame);
+    void keyboard_handler(void* t_context);
 
 }
 
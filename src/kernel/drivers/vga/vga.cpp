@@ -1,5 +1,6 @@
 #include "common.hpp"
 #include "vga.hpp"
+#include "sync/spinlock.hpp"
 
 namespace Kernel::VGA {
 
@@ -10,70 +11,121 @@ namespace Kernel::VGA {
 
     static CursorPos cursor = { 0, 0 };
 
+    // Guards the cursor and the text buffer, the public functions take it and the *_unlocked ones expect it held
+    static Sync::IRQSpinLock s_vgaLock("vga");
+
+    void put_char_unlocked(char t_c);
+    void put_string_unlocked(const char* t_string);
+    void put_unsigned_decimal_unlocked(u32 t_value);
+    void new_line_unlocked();
+    void set_cursor_pos_unlocked(u8 t_x, u8 t_y);
+
     void initialize() {
         clear_screen();
     }
 
     void clear_screen() {
+        Sync::LockGuard guard(s_vgaLock);
+
         for (u32 i = 0; i < TTY_WIDTH * TTY_HEIGHT; i++) {
             TEXT_BUFFER[i] = 0x0700;
         }
-        set_cursor_pos(0, 0);
+        set_cursor_pos_unlocked(0, 0);
     }
 
     void put_char(char t_c) {
-        TEXT_BUFFER[cursor.y * TTY_WIDTH + cursor.x] = 0x0700 | t_c;
-        const u8 newX = (cursor.x + 1) % TTY_WIDTH;
-        const u8 newY = (newX == 0) ? (cursor.y + 1) : (cursor.y);
-        set_cursor_pos(newX, newY);
+        Sync::LockGuard guard(s_vgaLock);
+        put_char_unlocked(t_c);
     }
 
     void put_string(const char* t_string) {
-        for (const char* p = t_string; *p != '\0'; p++) {
-            const char c = *p;
-            switch (c) {
-                case '\n':
-                    new_line();
-                    break;
-                case '\b':
-                    if (cursor.x > 0) {
-                        set_cursor_pos(cursor.x - 1, cursor.y);
-                    }
-                    break;
-                case '\r':
-                    set_cursor_pos(0, cursor.y);
-                    break;
-                default:
-                    put_char(c);
-            }
-        }
+        Sync::LockGuard guard(s_vgaLock);
+        put_string_unlocked(t_string);
     }
 
     void put_hex(u32 t_value) {
-        put_string("0x");
+        Sync::LockGuard guard(s_vgaLock);
+
+        put_string_unlocked("0x");
         for (u32 i = 0; i < 2 * sizeof(u32); i++) {
             const u8 hexDigit = t_value >> 28;
             if (hexDigit < 10) {
-                put_char(hexDigit + '0');
+                put_char_unlocked(hexDigit + '0');
             }
             else {
-                put_char((hexDigit - 10) + 'A');
+                put_char_unlocked((hexDigit - 10) + 'A');
             }
             t_value = t_value << 4;
         }
     }
 
     void put_signed_decimal(s32 t_value) {
+        Sync::LockGuard guard(s_vgaLock);
+
         if (t_value < 0) {
-            put_char('-');
+            put_char_unlocked('-');
             t_value = -t_value;
         }
-        put_unsigned_decimal(t_value);
+
+        put_unsigned_decimal_unlocked(t_value);
     }
 
     void put_unsigned_decimal(u32 t_value) {
+        Sync::LockGuard guard(s_vgaLock);
+        put_unsigned_decimal_unlocked(t_value);
+    }
+
+    void new_line() {
+        Sync::LockGuard guard(s_vgaLock);
+        new_line_unlocked();
+    }
+
+    CursorPos get_cursor_pos() {
+        Sync::LockGuard guard(s_vgaLock);
+        return cursor;
+    }
+
+    void set_cursor_pos(u8 t_x, u8 t_y) {
+        Sync::LockGuard guard(s_vgaLock);
+        set_cursor_pos_unlocked(t_x, t_y);
+    }
+
+    void offset_cursor(u8 t_dx, u8 t_dy) {
+        Sync::LockGuard guard(s_vgaLock);
+        set_cursor_pos_unlocked(cursor.x + t_dx, cursor.y + t_dy);
+    }
+
+    void put_char_unlocked(char t_c) {
+        TEXT_BUFFER[cursor.y * TTY_WIDTH + cursor.x] = 0x0700 | t_c;
+        const u8 newX = (cursor.x + 1) % TTY_WIDTH;
+        const u8 newY = (newX == 0) ? (cursor.y + 1) : (cursor.y);
+        set_cursor_pos_unlocked(newX, newY);
+    }
+
+    void put_string_unlocked(const char* t_string) {
+        for (const char* p = t_string; *p != '\0'; p++) {
+            const char c = *p;
+            switch (c) {
+                case '\n':
+                    new_line_unlocked();
+                    break;
+                case '\b':
+                    if (cursor.x > 0) {
+                        set_cursor_pos_unlocked(cursor.x - 1, cursor.y);
+                    }
+                    break;
+                case '\r':
+                    set_cursor_pos_unlocked(0, cursor.y);
+                    break;
+                default:
+                    put_char_unlocked(c);
+            }
+        }
+    }
+
+    void put_unsigned_decimal_unlocked(u32 t_value) {
         if (t_value == 0) {
-            put_char('0');
+            put_char_unlocked('0');
             return;
         }
 
@@ -91,20 +143,16 @@ namespace Kernel::VGA {
         // Print digits in reverse order (so that 123 get printed as 123 and not 321)
         const s32 noDigits = i;
         for (s32 i = noDigits - 1; i >= 0; i--) {
-            put_char(DIGIT_BUFFER[i]);
+            put_char_unlocked(DIGIT_BUFFER[i]);
         }
 
     }
 
-    void new_line() {
-        set_cursor_pos(0, cursor.y + 1);
+    void new_line_unlocked() {
+        set_cursor_pos_unlocked(0, cursor.y + 1);
     }
 
-    CursorPos get_cursor_pos() {
-        return cursor;
-    }
-
-    void set_cursor_pos(u8 t_x, u8 t_y) {
+    void set_cursor_pos_unlocked(u8 t_x, u8 t_y) {
         cursor.x = t_x;
         cursor.y = t_y;
 
@@ -127,8 +175,4 @@ namespace Kernel::VGA {
         port_write_byte(0x3D5, cursorPos & 0xFF);
     }
 
-    void offset_cursor(u8 t_dx, u8 t_dy) {
-        set_cursor_pos(cursor.x + t_dx, cursor.y + t_dy);
-    }
-
 }
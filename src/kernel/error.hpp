@@ -13,14 +13,19 @@
     DO(DRIVER_DEVICE_NO_RESPONSE)\
     DO(DRIVER_DEVICE_CHECK_FAILED)\
     DO(DRIVER_COMMAND_FAILED)\
+    DO(DRIVER_COMMAND_REFUSED)\
     DO(DRIVER_DEVICE_UNKNOWN)\
     DO(DRIVER_INVALID_DEVICE)\
     \
     DO(MEMORY_MANAGER_NO_FREE_BLOCKS)\
     DO(MEMORY_MANAGER_FAILED_TO_FIND_MEMORY_REGION)\
     \
+    DO(ACPI_TABLE_NOT_FOUND)\
+    DO(ACPI_INVALID_CHECKSUM)\
+    \
     DO(CONTAINER_IS_FULL)\
-    DO(CONTAINER_IS_EMPTY)
+    DO(CONTAINER_IS_EMPTY)\
+    DO(CONTAINER_KEY_NOT_FOUND)
 
 #define MAKE_ENUM(VAR) VAR,
 #define MAKE_STRING(VAR) #VAR,
@@ -2,10 +2,6 @@
 
 namespace Kernel::GDT {
 
-    struct GDTEntry {
-        u16 w1, w2, w3, w4;
-    };
-
     struct GDT {
         u16 _; // unused
         u16 size;
@@ -41,4 +37,41 @@ namespace Kernel::GDT {
         asm volatile ("lgdt (%0)" : : "r" (gdtPointer) );
     }
 
+    constexpr GDTEntry make_entry(u32 t_base, u32 t_limit, u8 t_access, u8 t_flags) {
+        return GDTEntry{
+            static_cast<u16>(t_limit & 0xFFFF),
+            static_cast<u16>(t_base & 0xFFFF),
+            static_cast<u16>(((t_base >> 16) & 0xFF) | (t_access << 8)),
+            static_cast<u16>(((t_limit >> 16) & 0x0F) | ((t_flags & 0x0F) << 4) | (((t_base >> 24) & 0xFF) << 8))
+        };
+    }
+
+    void initialize_cpu_table(CPUTable& r_table, u32 t_cpuDataBase, u32 t_cpuDataSize) {
+        r_table.entries[0] = GDTEntry{ 0x0000, 0x0000, 0x0000, 0x0000 }; // NULL
+        r_table.entries[1] = GDTEntry{ 0xFFFF, 0x0000, 0x9A00, 0x00CF }; // KERNEL_CODE
+        r_table.entries[2] = GDTEntry{ 0xFFFF, 0x0000, 0x9200, 0x00CF }; // KERNEL_DATA
+        r_table.entries[3] = make_entry(t_cpuDataBase, t_cpuDataSize - 1, 0x92, 0x4); // CPU_DATA, byte granular
+    }
+
+    void load_cpu_table(CPUTable& t_table) {
+        GDT descriptor = { 0, sizeof(CPUTable) - 1, &t_table.entries[0] };
+
+        u8* gdtPointer = ((u8*) &descriptor) + 2; // ignore unused bytes in struct
+        asm volatile (
+            "lgdt (%0)\n"
+            "ljmp %1, $1f\n"
+            "1:\n"
+            "movw %2, %%ax\n"
+            "movw %%ax, %%ds\n"
+            "movw %%ax, %%es\n"
+            "movw %%ax, %%fs\n"
+            "movw %%ax, %%ss\n"
+            "movw %3, %%ax\n"
+            "movw %%ax, %%gs\n"
+            :
+            : "r" (gdtPointer), "i" (KERNEL_CODE_SELECTOR), "i" (KERNEL_DATA_SELECTOR), "i" (CPU_DATA_SELECTOR)
+            : "eax", "memory"
+        );
+    }
+
 }
@@ -6,12 +6,33 @@
 
 namespace Kernel::GDT {
 
+    struct GDTEntry {
+        u16 w1, w2, w3, w4;
+    };
+
+    constexpr u16 KERNEL_CODE_SELECTOR = 0x08;
+    constexpr u16 KERNEL_DATA_SELECTOR = 0x10;
+    constexpr u16 CPU_DATA_SELECTOR    = 0x18;
+
+    constexpr size_t CPU_TABLE_ENTRY_COUNT = 4;
+
+    // Each CPU gets its own table: the flat kernel segments plus a data segment based at the CPU's
+    // per-CPU block, which is loaded into GS
+    struct CPUTable {
+        GDTEntry entries[CPU_TABLE_ENTRY_COUNT];
+    };
+
     void initialize();
 
     Data::ErrorOr<void> add_entry(u16, u16, u16, u16);
 
     void load_table();
 
+    void initialize_cpu_table(CPUTable& r_table, u32 t_cpuDataBase, u32 t_cpuDataSize);
+
+    // Switches the calling CPU to t_table and reloads every segment register
+    void load_cpu_table(CPUTable& t_table);
+
 }
 
 #endif
@@ -50,7 +50,7 @@ namespace Kernel::IDT {
         for (size_t i = 0; i < IDT_MAX_ENTRY_COUNT; i++) {
             set_entry(i, (void*)&InterruptHandler::interrupt_handler, 0x00000008, IDTGateType::INTERRUPT, true);
         }
-        KERNEL_IDT.size = sizeof(IDTEntry) * IDT_MAX_ENTRY_COUNT;
+        KERNEL_IDT.size = sizeof(IDTEntry) * IDT_MAX_ENTRY_COUNT - 1; // size should contain size of all entries - 1
     }
 
     IDTEntry idt_entry_create(u32 t_offset, u16 t_segmentSelector, IDTGateType t_gateType, bool t_32bit) {
@@ -78,8 +78,6 @@ namespace Kernel::IDT {
     }
 
     void load_table() {
-        KERNEL_IDT.size -= 1; // size should contain size of all entries - 1
-
         u8* idtPointer = ((u8*) &KERNEL_IDT) + 2; // ignore unused bytes in struct
         asm volatile ("lidt (%0)" : : "r" (idtPointer));
     }
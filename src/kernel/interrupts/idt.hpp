@@ -16,6 +16,7 @@ namespace Kernel::IDT {
 
     Data::ErrorOr<void> set_entry(size_t t_index, void* t_handlerAddress, u16 t_segmentSelector, IDTGateType t_gateType, bool t_32bit);
 
+    // Every CPU shares the same table, so this is also called by each application processor as it starts
     void load_table();
 
 }
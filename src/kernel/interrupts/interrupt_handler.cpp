@@ -1,11 +1,10 @@
 #include "interrupt_handler.hpp"
-#include "pic.hpp"
 
 namespace Kernel::InterruptHandler {
 
     INTERRUPT_HANDLER void interrupt_handler(InterruptFrame* t_frame) {
-        // Acknowledge interrupt
-        PIC::send_end_of_interrupt(0);
+        // PIC lines have their own entry stubs (see irq.cpp) so nothing arriving here needs an end of interrupt
+        (void)t_frame;
     }
 
 }
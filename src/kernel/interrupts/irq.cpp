@@ -0,0 +1,282 @@
+#include "irq.hpp"
+#include "idt.hpp"
+#include "pic.hpp"
+#include "softirq.hpp"
+#include "data/vector.hpp"
+#include "drivers/vga/vga.hpp"
+#include "scheduler/scheduler.hpp"
+
+namespace Kernel::IRQ {
+
+    struct HandlerEntry {
+        Handler handler;
+        void* context;
+    };
+
+    // Defined in irq_stubs.asm, one entry stub per PIC line
+    extern "C" void* irq_stub_table[PIC::IRQ_COUNT];
+
+    extern "C" void irq_dispatch(u32 t_line, u64 t_entryTimestamp);
+
+    void record_dispatch(u32 t_line, u32 t_handlerCycles, u32 t_latencyCycles);
+
+    static Data::SmallVector<HandlerEntry, INLINE_HANDLERS_PER_LINE> s_handlers[PIC::IRQ_COUNT];
+    static Statistics s_statistics[PIC::IRQ_COUNT];
+
+    // Set while print_dispatch_benchmark raises lines, dispatch then skips the deferred work and preemption
+    static volatile bool s_benchmarkRunning = false;
+
+    constexpr size_t get_vector(u8 t_line) {
+        return (t_line < 8) ? (PIC::PIC1_VECTOR_OFFSET + t_line) : (PIC::PIC2_VECTOR_OFFSET + (t_line - 8));
+    }
+
+    // int only takes an immediate vector
+    template <u8 LINE>
+    static void raise_line() {
+        asm volatile("int %0" : : "i"(get_vector(LINE)) : "memory");
+    }
+
+    static void (*const s_raiseLine[PIC::IRQ_COUNT])() = {
+        raise_line<0>, raise_line<1>, raise_line<2>, raise_line<3>,
+        raise_line<4>, raise_line<5>, raise_line<6>, raise_line<7>,
+        raise_line<8>, raise_line<9>, raise_line<10>, raise_line<11>,
+        raise_line<12>, raise_line<13>, raise_line<14>, raise_line<15>
+    };
+
+    Data::ErrorOr<void> initialize() {
+        for (u8 line = 0; line < PIC::IRQ_COUNT; line++) {
+            TRY(IDT::set_entry(get_vector(line), irq_stub_table[line], 0x00000008, IDT::IDTGateType::INTERRUPT, true));
+
+            if (line != PIC::CASCADE_IRQ) {
+                PIC::set_mask(line);
+            }
+        }
+        PIC::clear_mask(PIC::CASCADE_IRQ);
+
+        return Data::ErrorOr<void>();
+    }
+
+    Data::ErrorOr<void> register_handler(u8 t_line, Handler t_handler, void* t_context) {
+        ASSERT(t_line < PIC::IRQ_COUNT, Error::INDEX_OUT_OF_RANGE);
+        ASSERT(t_handler != nullptr, Error::INVALID_ARGUMENT);
+
+        const u32 flags = save_and_disable_interrupts();
+        const auto result = s_handlers[t_line].push_back(HandlerEntry{ t_handler, t_context });
+        if (!result.is_error()) {
+            PIC::clear_mask(t_line);
+        }
+        restore_interrupts(flags);
+
+        return result;
+    }
+
+    Data::ErrorOr<void> unregister_handler(u8 t_line, Handler t_handler, void* t_context) {
+        ASSERT(t_line < PIC::IRQ_COUNT, Error::INDEX_OUT_OF_RANGE);
+
+        auto& handlers = s_handlers[t_line];
+
+        const u32 flags = save_and_disable_interrupts();
+        for (size_t i = 0; i < handlers.size(); i++) {
+            if (handlers[i].handler == t_handler && handlers[i].context == t_context) {
+                handlers.remove(i);
+                if (handlers.empty() && t_line != PIC::CASCADE_IRQ) {
+                    PIC::set_mask(t_line);
+                }
+
+                restore_interrupts(flags);
+                return Data::ErrorOr<void>();
+            }
+        }
+        restore_interrupts(flags);
+
+        return Error::INVALID_ARGUMENT;
+    }
+
+    Data::ErrorOr<Statistics> get_statistics(u8 t_line) {
+        ASSERT(t_line < PIC::IRQ_COUNT, Error::INDEX_OUT_OF_RANGE);
+
+        const u32 flags = save_and_disable_interrupts();
+        const Statistics statistics = s_statistics[t_line];
+        restore_interrupts(flags);
+
+        return statistics;
+    }
+
+    void reset_statistics() {
+        const u32 flags = save_and_disable_interrupts();
+        memset(s_statistics, 0, sizeof(s_statistics));
+        restore_interrupts(flags);
+    }
+
+    void print_statistics() {
+        VGA::put_string("IRQ Statistics\n--------------\n");
+
+        for (u8 line = 0; line < PIC::IRQ_COUNT; line++) {
+            const Statistics statistics = get_statistics(line).get_value();
+            if (statistics.count == 0 && statistics.spurious == 0) {
+                continue;
+            }
+
+            VGA::put_string("IRQ ");
+            VGA::put_unsigned_decimal(line);
+            VGA::put_string(": ");
+            VGA::put_unsigned_decimal(statistics.count);
+            VGA::put_string(" calls, ");
+            VGA::put_unsigned_decimal(statistics.spurious);
+            VGA::put_string(" spurious\n");
+            if (statistics.count == 0) {
+                continue;
+            }
+
+            VGA::put_string("  handlers avg ");
+            VGA::put_unsigned_decimal(static_cast<u32>(statistics.totalCycles / statistics.count));
+            VGA::put_string(" max ");
+            VGA::put_unsigned_decimal(statistics.maxCycles);
+            VGA::put_string(", latency avg ");
+            VGA::put_unsigned_decimal(static_cast<u32>(statistics.totalLatencyCycles / statistics.count));
+            VGA::put_string(" max ");
+            VGA::put_unsigned_decimal(statistics.maxLatencyCycles);
+            VGA::put_string(" cycles\n ");
+
+            for (size_t i = 0; i < LATENCY_HISTOGRAM_SIZE; i++) {
+                if (statistics.latencyHistogram[i] != 0) {
+                    VGA::put_string(" 2^");
+                    VGA::put_unsigned_decimal(i);
+                    VGA::put_char(':');
+                    VGA::put_unsigned_decimal(statistics.latencyHistogram[i]);
+                }
+            }
+            VGA::new_line();
+        }
+
+        VGA::new_line();
+    }
+
+    static void count_benchmark_interrupt(void* t_context) {
+        volatile u32* count = static_cast<volatile u32*>(t_context);
+        *count = *count + 1;
+    }
+
+    void print_dispatch_benchmark() {
+        constexpr size_t ITERATION_COUNT = 1000;
+
+        VGA::put_string("IRQ dispatch, cycles per interrupt\n----------------------------------\n");
+
+        for (u8 line = 0; line < PIC::IRQ_COUNT; line++) {
+            // The cascade never reaches the dispatcher, and a raised IRQ7/IRQ15 that isn't in service counts as spurious
+            if (line == PIC::CASCADE_IRQ || line == 7 || line == 15) {
+                continue;
+            }
+
+            const u32 flags = save_and_disable_interrupts();
+            auto& handlers = s_handlers[line];
+
+            if (!handlers.empty()) {
+                const Statistics statistics = s_statistics[line];
+                restore_interrupts(flags);
+
+                VGA::put_string("IRQ ");
+                VGA::put_unsigned_decimal(line);
+                if (statistics.count == 0) {
+                    VGA::put_string(": in use, not raised yet\n");
+                    continue;
+                }
+                VGA::put_string(": in use, ");
+                VGA::put_unsigned_decimal(static_cast<u32>((statistics.totalLatencyCycles - statistics.totalCycles) / statistics.count));
+                VGA::put_string(" around the handlers\n");
+                continue;
+            }
+
+            // Added directly so the line stays masked on the PIC, only int reaches it. Dispatch skips the softirqs,
+            // which would enable interrupts, and preemption while the flag is set, so nothing else lands in the loop
+            volatile u32 count = 0;
+            if (handlers.push_back(HandlerEntry{ count_benchmark_interrupt, const_cast<u32*>(&count) }).is_error()) {
+                restore_interrupts(flags);
+                VGA::put_string("Out of memory\n");
+                break;
+            }
+            const Statistics savedStatistics = s_statistics[line];
+
+            u64 totalCycles = 0;
+            u32 minCycles = 0xFFFFFFFF;
+            s_benchmarkRunning = true;
+            for (size_t i = 0; i < ITERATION_COUNT; i++) {
+                const u64 start = read_timestamp_counter();
+                s_raiseLine[line]();
+                const u32 cycles = static_cast<u32>(read_timestamp_counter() - start);
+
+                totalCycles += cycles;
+                if (cycles < minCycles) {
+                    minCycles = cycles;
+                }
+            }
+
+            s_benchmarkRunning = false;
+
+            handlers.remove(0);
+            s_statistics[line] = savedStatistics;
+            restore_interrupts(flags);
+
+            VGA::put_string("IRQ ");
+            VGA::put_unsigned_decimal(line);
+            VGA::put_string(": avg ");
+            VGA::put_unsigned_decimal(static_cast<u32>(totalCycles / ITERATION_COUNT));
+            VGA::put_string(", min ");
+            VGA::put_unsigned_decimal(minCycles);
+            VGA::put_string(count == ITERATION_COUNT ? "\n" : ", MISSED\n");
+        }
+
+        VGA::new_line();
+    }
+
+    void record_dispatch(u32 t_line, u32 t_handlerCycles, u32 t_latencyCycles) {
+        Statistics& statistics = s_statistics[t_line];
+
+        const size_t bucket = 31 - __builtin_clz(t_latencyCycles | 1);
+
+        statistics.count++;
+        statistics.totalCycles += t_handlerCycles;
+        if (t_handlerCycles > statistics.maxCycles) {
+            statistics.maxCycles = t_handlerCycles;
+        }
+
+        statistics.totalLatencyCycles += t_latencyCycles;
+        statistics.latencyHistogram[bucket]++;
+        if (t_latencyCycles > statistics.maxLatencyCycles) {
+            statistics.maxLatencyCycles = t_latencyCycles;
+        }
+    }
+
+    void irq_dispatch(u32 t_line, u64 t_entryTimestamp) {
+        if (PIC::is_spurious(t_line)) {
+            s_statistics[t_line].spurious++;
+            return;
+        }
+
+        const u64 start = read_timestamp_counter();
+
+        const auto& handlers = s_handlers[t_line];
+        for (size_t i = 0; i < handlers.size(); i++) {
+            handlers[i].handler(handlers[i].context);
+        }
+
+        PIC::send_end_of_interrupt(t_line);
+
+        // Deferred work runs with interrupts enabled so it is not counted against the line
+        const u64 end = read_timestamp_counter();
+        record_dispatch(t_line, static_cast<u32>(end - start), static_cast<u32>(end - t_entryTimestamp));
+
+        // The benchmark's own int, whatever is pending runs on the next real interrupt
+        if (s_benchmarkRunning) {
+            return;
+        }
+
+        SoftIRQ::run_pending();
+
+        // Switching away while an outer frame is still draining deferred work would stall it until we come back
+        if (!SoftIRQ::is_running()) {
+            Scheduler::preempt_if_needed();
+        }
+    }
+
+}
@@ -0,0 +1,55 @@
+#ifndef IRQ_INCLUDED
+#define IRQ_INCLUDED
+
+#include "common.hpp"
+#include "data/error_or.hpp"
+
+namespace Kernel::IRQ {
+
+    enum Line : u8 {
+        LINE_TIMER    = 0,
+        LINE_KEYBOARD = 1,
+        LINE_FLOPPY   = 6,
+    };
+
+    // Called with interrupts disabled, end of interrupt is sent by the dispatcher once every handler on the line has run
+    using Handler = void (*)(void* t_context);
+
+    // Lines with more handlers than this keep them on the heap instead
+    constexpr size_t INLINE_HANDLERS_PER_LINE = 4;
+
+    constexpr size_t LATENCY_HISTOGRAM_SIZE = 32;
+
+    struct Statistics {
+        u32 count;
+        u32 spurious;    // IRQ7/IRQ15 noise, not part of count and not dispatched
+        u64 totalCycles; // spent in the line's handlers
+        u32 maxCycles;
+
+        // Latency runs from the entry stub to the end of interrupt, so it includes the dispatch around the handlers.
+        // Entry i of the histogram counts interrupts taking [2^i, 2^(i+1)) TSC cycles
+        u64 totalLatencyCycles;
+        u32 maxLatencyCycles;
+        u32 latencyHistogram[LATENCY_HISTOGRAM_SIZE];
+    };
+
+    // Points every PIC vector at its entry stub and masks all lines until a handler is registered
+    Data::ErrorOr<void> initialize();
+
+    // Adds a handler to t_line, several handlers can share the same line and are called in registration order
+    Data::ErrorOr<void> register_handler(u8 t_line, Handler t_handler, void* t_context);
+    Data::ErrorOr<void> unregister_handler(u8 t_line, Handler t_handler, void* t_context);
+
+    // Counters are only written by the dispatcher, reading them takes a consistent snapshot
+    Data::ErrorOr<Statistics> get_statistics(u8 t_line);
+    void reset_statistics();
+
+    void print_statistics();
+
+    // Cost of a dispatch on every line. Free lines get a no-op handler and are raised with int, lines in use are
+    // given the overhead their statistics show on top of the handlers
+    void print_dispatch_benchmark();
+
+}
+
+#endif
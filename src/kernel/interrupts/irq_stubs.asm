@@ -0,0 +1,56 @@
+; Entry stubs for the 16 PIC lines. Only the caller-saved registers are pushed since
+; irq_dispatch preserves ebx, esi, edi and ebp itself, and every segment register
+; already holds the flat kernel segments. The TSC is read first thing, so the IRQ
+; statistics can measure latency from when the CPU took the interrupt.
+
+extern irq_dispatch
+
+SECTION .text
+
+%macro IRQ_STUB 1
+irq_stub_%1:
+    push eax
+    push ecx
+    push edx
+    rdtsc
+    push edx                ; irq_dispatch(t_line, t_entryTimestamp)
+    push eax
+    push dword %1
+    jmp irq_common_entry
+%endmacro
+
+irq_common_entry:
+    cld
+    call irq_dispatch
+    add esp, 12
+    pop edx
+    pop ecx
+    pop eax
+    iret
+
+IRQ_STUB 0
+IRQ_STUB 1
+IRQ_STUB 2
+IRQ_STUB 3
+IRQ_STUB 4
+IRQ_STUB 5
+IRQ_STUB 6
+IRQ_STUB 7
+IRQ_STUB 8
+IRQ_STUB 9
+IRQ_STUB 10
+IRQ_STUB 11
+IRQ_STUB 12
+IRQ_STUB 13
+IRQ_STUB 14
+IRQ_STUB 15
+
+SECTION .data
+
+global irq_stub_table
+irq_stub_table:
+%assign i 0
+%rep 16
+    dd irq_stub_%+i
+%assign i i+1
+%endrep
@@ -0,0 +1,83 @@
+#include "lapic.hpp"
+
+namespace Kernel::LAPIC {
+
+    enum Register {
+        REGISTER_ID                   = 0x020,
+        REGISTER_EOI                  = 0x0B0,
+        REGISTER_SPURIOUS_VECTOR      = 0x0F0,
+        REGISTER_ERROR_STATUS         = 0x280,
+        REGISTER_INTERRUPT_COMMAND_LO = 0x300,
+        REGISTER_INTERRUPT_COMMAND_HI = 0x310,
+    };
+
+    constexpr u32 SPURIOUS_VECTOR_ENABLE = 1 << 8;
+
+    constexpr u32 ICR_DELIVERY_MODE_FIXED   = 0b000 << 8;
+    constexpr u32 ICR_DELIVERY_MODE_INIT    = 0b101 << 8;
+    constexpr u32 ICR_DELIVERY_MODE_STARTUP = 0b110 << 8;
+    constexpr u32 ICR_DELIVERY_STATUS       = 1 << 12;
+    constexpr u32 ICR_LEVEL_ASSERT          = 1 << 14;
+    constexpr u32 ICR_ALL_EXCLUDING_SELF    = 0b11 << 18;
+
+    constexpr size_t DELIVERY_POLL_COUNT = 100000;
+
+    static u32 s_baseAddress = DEFAULT_BASE_ADDRESS;
+
+    u32 read_register(Register t_register) {
+        return *reinterpret_cast<volatile u32*>(s_baseAddress + t_register);
+    }
+
+    void write_register(Register t_register, u32 t_value) {
+        *reinterpret_cast<volatile u32*>(s_baseAddress + t_register) = t_value;
+    }
+
+    Data::ErrorOr<void> send_ipi(u8 t_apicId, u32 t_command) {
+        // An IRQ handler sending its own IPI between the two writes would change the destination under us
+        const u32 flags = save_and_disable_interrupts();
+
+        write_register(REGISTER_ERROR_STATUS, 0); // clear any error left by a previous IPI
+        write_register(REGISTER_INTERRUPT_COMMAND_HI, static_cast<u32>(t_apicId) << 24);
+        write_register(REGISTER_INTERRUPT_COMMAND_LO, t_command); // writing the low half sends the IPI
+
+        bool delivered = false;
+        for (size_t i = 0; i < DELIVERY_POLL_COUNT && !delivered; i++) {
+            delivered = (read_register(REGISTER_INTERRUPT_COMMAND_LO) & ICR_DELIVERY_STATUS) == 0;
+            asm volatile ("pause");
+        }
+
+        restore_interrupts(flags);
+
+        ASSERT(delivered, Error::RETRY_LIMIT_REACHED);
+        return Data::ErrorOr<void>();
+    }
+
+    void set_base_address(u32 t_address) {
+        s_baseAddress = t_address;
+    }
+
+    u8 get_id() {
+        return static_cast<u8>(read_register(REGISTER_ID) >> 24);
+    }
+
+    void enable() {
+        write_register(REGISTER_SPURIOUS_VECTOR, SPURIOUS_VECTOR_ENABLE | SPURIOUS_VECTOR);
+    }
+
+    Data::ErrorOr<void> send_init(u8 t_apicId) {
+        return send_ipi(t_apicId, ICR_DELIVERY_MODE_INIT | ICR_LEVEL_ASSERT);
+    }
+
+    Data::ErrorOr<void> send_startup(u8 t_apicId, u8 t_vector) {
+        return send_ipi(t_apicId, ICR_DELIVERY_MODE_STARTUP | ICR_LEVEL_ASSERT | t_vector);
+    }
+
+    Data::ErrorOr<void> send_to_others(u8 t_vector) {
+        return send_ipi(0, ICR_DELIVERY_MODE_FIXED | ICR_LEVEL_ASSERT | ICR_ALL_EXCLUDING_SELF | t_vector);
+    }
+
+    void send_end_of_interrupt() {
+        write_register(REGISTER_EOI, 0);
+    }
+
+}
@@ -0,0 +1,31 @@
+#ifndef LAPIC_INCLUDED
+#define LAPIC_INCLUDED
+
+#include "common.hpp"
+#include "data/error_or.hpp"
+
+namespace Kernel::LAPIC {
+
+    constexpr u32 DEFAULT_BASE_ADDRESS = 0xFEE00000;
+    constexpr u8 SPURIOUS_VECTOR = 0xFF;
+
+    // The MADT gives the real address, this only needs calling if it differs from the default
+    void set_base_address(u32 t_address);
+
+    u8 get_id();
+
+    // Software enables the calling CPU's local APIC. The BSP's is left alone so the PIC keeps delivering through LINT0
+    void enable();
+
+    // Inter-processor interrupts used to start an application processor
+    Data::ErrorOr<void> send_init(u8 t_apicId);
+    Data::ErrorOr<void> send_startup(u8 t_apicId, u8 t_vector);
+
+    // Sends a fixed interrupt with t_vector to every CPU except the calling one
+    Data::ErrorOr<void> send_to_others(u8 t_vector);
+
+    void send_end_of_interrupt();
+
+}
+
+#endif
@@ -13,6 +13,7 @@ namespace Kernel::PIC {
     constexpr u8 PIC2_DATA = PIC2 + 1;
 
     constexpr u8 PIC_EOI = 0x20;
+    constexpr u8 PIC_READ_ISR = 0x0B; // OCW3 - read in-service register on the next command port read
 
     constexpr u8 ICW1_ICW4      = 0x01; // ICW4 (not) needed
     constexpr u8 ICW1_SINGLE    = 0x02; // Single cascade mode
@@ -26,9 +27,6 @@ namespace Kernel::PIC {
     constexpr u8 ICW4_BUF_MASTER = 0x0C; // Buffered mode/master
     constexpr u8 ICW4_SFNM       = 0x10; // Special fully nested (not)
 
-    constexpr u8 PIC1_VECTOR_OFFSET = 0x20; // Set offset to start of valid range
-    constexpr u8 PIC2_VECTOR_OFFSET = 0x28;
-
     void initialize() {
         const char a1 = port_read_byte(PIC1_DATA); // Save masks
         const char a2 = port_read_byte(PIC2_DATA);
@@ -67,4 +65,34 @@ namespace Kernel::PIC {
         port_write_byte(PIC1_COMMAND, PIC_EOI);
     }
 
+    void set_mask(u8 t_irq) {
+        const u8 port = (t_irq < 8) ? (PIC1_DATA) : (PIC2_DATA);
+        const u8 mask = port_read_byte(port) | (1 << (t_irq % 8));
+        port_write_byte(port, mask);
+    }
+
+    void clear_mask(u8 t_irq) {
+        const u8 port = (t_irq < 8) ? (PIC1_DATA) : (PIC2_DATA);
+        const u8 mask = port_read_byte(port) & ~(1 << (t_irq % 8));
+        port_write_byte(port, mask);
+    }
+
+    bool is_spurious(u8 t_irq) {
+        if (t_irq != 7 && t_irq != 15) {
+            return false;
+        }
+
+        const u8 command = (t_irq < 8) ? (PIC1_COMMAND) : (PIC2_COMMAND);
+        port_write_byte(command, PIC_READ_ISR);
+        if (port_read_byte(command) & (1 << (t_irq % 8))) {
+            return false;
+        }
+
+        // The master still saw a real interrupt on the cascade line so it needs acknowledging
+        if (t_irq >= 8) {
+            port_write_byte(PIC1_COMMAND, PIC_EOI);
+        }
+        return true;
+    }
+
 }
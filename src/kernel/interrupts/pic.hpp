@@ -5,10 +5,22 @@
 
 namespace Kernel::PIC {
 
+    constexpr u8 PIC1_VECTOR_OFFSET = 0x20; // Set offset to start of valid range
+    constexpr u8 PIC2_VECTOR_OFFSET = 0x28;
+
+    constexpr u8 IRQ_COUNT = 16;
+    constexpr u8 CASCADE_IRQ = 2;
+
     void initialize();
 
     void send_end_of_interrupt(u8 t_irq);
 
+    void set_mask(u8 t_irq);
+    void clear_mask(u8 t_irq);
+
+    // Returns true if t_irq was not actually raised (IRQ7/IRQ15 noise), acknowledging the master PIC if needed
+    bool is_spurious(u8 t_irq);
+
 }
 
 #endif
@@ -0,0 +1,56 @@
+#include "softirq.hpp"
+#include "data/spsc_ring.hpp"
+
+namespace Kernel::SoftIRQ {
+
+    constexpr size_t DRAIN_BATCH_SIZE = 8;
+
+    static struct {
+        Data::SPSCRing<WorkItem, WORK_QUEUE_SIZE> queue; // interrupt handlers are the producer, run_pending the consumer
+        bool running;
+    } s_softIRQState;
+
+    Data::ErrorOr<void> raise(WorkFunction t_function, u32 t_data) {
+        ASSERT(t_function != nullptr, Error::INVALID_ARGUMENT);
+
+        // Handlers can nest, keep them from pushing at the same time
+        const u32 flags = save_and_disable_interrupts();
+        const auto result = s_softIRQState.queue.push(WorkItem{ t_function, t_data });
+        restore_interrupts(flags);
+
+        return result;
+    }
+
+    void run_pending() {
+        const u32 flags = save_and_disable_interrupts();
+
+        // An interrupt arriving while we drain the queue must not start draining it again further up the stack
+        if (s_softIRQState.running) {
+            restore_interrupts(flags);
+            return;
+        }
+        s_softIRQState.running = true;
+        enable_interrupts();
+
+        // This is the only consumer, so the ring can be drained with interrupts enabled
+        WorkItem batch[DRAIN_BATCH_SIZE];
+        for (size_t count = s_softIRQState.queue.pop_n(batch, DRAIN_BATCH_SIZE); count != 0; count = s_softIRQState.queue.pop_n(batch, DRAIN_BATCH_SIZE)) {
+            for (size_t i = 0; i < count; i++) {
+                batch[i].function(batch[i].data);
+            }
+        }
+
+        disable_interrupts();
+        s_softIRQState.running = false;
+        restore_interrupts(flags);
+    }
+
+    bool has_pending() {
+        return !s_softIRQState.queue.is_empty();
+    }
+
+    bool is_running() {
+        return s_softIRQState.running;
+    }
+
+}
@@ -0,0 +1,31 @@
+#ifndef SOFTIRQ_INCLUDED
+#define SOFTIRQ_INCLUDED
+
+#include "common.hpp"
+#include "data/error_or.hpp"
+
+namespace Kernel::SoftIRQ {
+
+    using WorkFunction = void (*)(u32 t_data);
+
+    struct WorkItem {
+        WorkFunction function;
+        u32 data;
+    };
+
+    constexpr size_t WORK_QUEUE_SIZE = 64; // must be a power of two
+
+    // Queues t_function to be called later with interrupts enabled, safe to call from an interrupt handler
+    Data::ErrorOr<void> raise(WorkFunction t_function, u32 t_data);
+
+    // Runs every queued work item with interrupts enabled, does nothing if the queue is already being drained
+    void run_pending();
+
+    [[nodiscard]] bool has_pending();
+
+    // True while some frame further up the stack is draining the queue
+    [[nodiscard]] bool is_running();
+
+}
+
+#endif
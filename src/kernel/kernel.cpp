@@ -1,14 +1,22 @@
 #include "common.hpp"
 #include "gdt.hpp"
+#include "async/executor.hpp"
+#include "data/benchmark.hpp"
 #include "interrupts/idt.hpp"
-#include "interrupts/interrupt_handler.hpp"
+#include "interrupts/irq.hpp"
 #include "interrupts/pic.hpp"
+#include "interrupts/softirq.hpp"
 #include "drivers/disk/floppy/floppy.hpp"
 #include "drivers/pit/pit.hpp"
 #include "drivers/ps2/ps2.hpp"
 #include "drivers/ps2/keyboard/keyboard.hpp"
 #include "drivers/vga/vga.hpp"
+#include "memory-manager/magazine.hpp"
 #include "memory-manager/manager.hpp"
+#include "scheduler/scheduler.hpp"
+#include "smp/smp.hpp"
+#include "smp/work.hpp"
+#include "sync/lock_statistics.hpp"
 
 namespace Kernel {
 
@@ -21,11 +29,13 @@ namespace Kernel {
     extern "C" void kernel_early_main();
     [[noreturn]] void kernel_main();
 
+    void floppy_thread_main(void* t_argument);
+
     void kernel_early_main() {
         _init();
 
         // Update the stack pointer
-        asm("movl %0, %%esp;" : : "r"(g_stack + sizeof(g_stack)) :);
+        asm("movl %0, %%esp;" : : "r"(g_stack + (STACK_SIZE / sizeof(u32))) :);
 
         kernel_main();
         _fini();
@@ -47,14 +57,27 @@ namespace Kernel {
         GDT::add_entry(0xFFFF, 0x0000, 0x9A00, 0x00CF); // KERNEL_CODE
         GDT::add_entry(0xFFFF, 0x0000, 0x9200, 0x00CF); // KERNEL_DATA
         GDT::load_table();
+        SMP::initialize_boot_cpu();
         VGA::put_string("Done!\n");
 
         VGA::put_string("Initializing IDT... ");
         IDT::initialize();
-        IDT::set_entry(0x20, (void*)&PIT::interval_handler, 0x00000008, IDT::IDTGateType::INTERRUPT, true);
-        IDT::set_entry(0x21, (void*)&PS2::Keyboard::keyboard_handler, 0x00000008, IDT::IDTGateType::INTERRUPT, true);
-        IDT::set_entry(0x26, (void*)&FloppyDisk::floppy_handler, 0x00000008, IDT::IDTGateType::INTERRUPT, true);
+        if (IRQ::initialize().is_error()) {
+            VGA::put_string("Failed :(\n");
+            KERNEL_STOP();
+        }
         IDT::load_table();
+        VGA::put_string("Done!\n");
+
+        VGA::put_string("Registering IRQ handlers... ");
+        if (
+            IRQ::register_handler(IRQ::LINE_TIMER, PIT::interval_handler, nullptr).is_error() ||
+            IRQ::register_handler(IRQ::LINE_KEYBOARD, PS2::Keyboard::keyboard_handler, nullptr).is_error() ||
+            IRQ::register_handler(IRQ::LINE_FLOPPY, FloppyDisk::floppy_handler, nullptr).is_error()
+        ) {
+            VGA::put_string("Failed :(\n");
+            KERNEL_STOP();
+        }
         VGA::put_string("Done!\n\n");
 
         VGA::put_string("Initializing PS/2 Controller... ");
@@ -81,33 +104,25 @@ namespace Kernel {
         VGA::put_hex(read_cmos(0x10));
         VGA::new_line();
 
-        VGA::put_string("Initializing Floppy Disk... ");
-        if (FloppyDisk::initialize().is_error()) {
-            VGA::put_string("Failed :(\n");
-            KERNEL_STOP();
-        }
-        VGA::put_string("Done!\n");
-
-        //*
-        u8 buffer[FloppyDisk::SECTOR_SIZE];
-        if (FloppyDisk::read_data(0, 80, 1, buffer).is_error()) {
-            VGA::put_string("Read failed :(\n");
-            KERNEL_STOP();
-        }
-
-        for (size_t i = 0; i < FloppyDisk::SECTOR_SIZE; i++) {
-            VGA::put_char(buffer[i]);
-        }
-        VGA::new_line();
-        //*/
-
         VGA::put_string("Initializing Memory Manager... ");
         if (MemoryManager::initialize().is_error()) {
             VGA::put_string("Failed :(\n");
             KERNEL_STOP();
         }
+        Magazine::initialize();
         VGA::put_string("Done!\n");
 
+        VGA::put_string("Starting application processors... ");
+        Work::initialize();
+        const auto smpResult = SMP::start_application_processors();
+        if (smpResult.is_error()) {
+            // Not fatal, the kernel just keeps running on the BSP alone
+            VGA::put_string(get_error_string(smpResult.get_error()));
+            VGA::put_string(" ");
+        }
+        VGA::put_unsigned_decimal(SMP::get_online_cpu_count());
+        VGA::put_string(" CPU(s) online\n");
+
         /*
         MemoryManager::print_heap_information();
 
@@ -126,7 +141,29 @@ namespace Kernel {
 
          */
 
+        VGA::put_string("Initializing Scheduler... ");
+        if (Scheduler::initialize().is_error()) {
+            VGA::put_string("Failed :(\n");
+            KERNEL_STOP();
+        }
+        VGA::put_string("Done!\n");
+
+        VGA::put_string("Initializing Async Executor... ");
+        if (Async::initialize().is_error()) {
+            VGA::put_string("Failed :(\n");
+            KERNEL_STOP();
+        }
+        VGA::put_string("Done!\n");
+
+        // The floppy driver waits a long time on the hardware so it gets its own thread to keep the keyboard responsive
+        if (Scheduler::create_thread("floppy", floppy_thread_main, nullptr).is_error()) {
+            VGA::put_string("Failed to start floppy thread :(\n");
+            KERNEL_STOP();
+        }
+
         while (true) {
+            SoftIRQ::run_pending();
+
             for (auto e = PS2::Keyboard::poll_event(); !e.is_error(); e = PS2::Keyboard::poll_event()) {
                 const auto event = e.get_value();
 
@@ -135,6 +172,42 @@ namespace Kernel {
                         case PS2::Keyboard::Keycode::KEYCODE_BACKSPACE:
                             VGA::put_string("\b \b");
                             break;
+                        case PS2::Keyboard::Keycode::KEYCODE_F1:
+                            VGA::new_line();
+                            IRQ::print_statistics();
+                            break;
+                        case PS2::Keyboard::Keycode::KEYCODE_F2:
+                            VGA::new_line();
+                            Work::print_scaling_benchmark();
+                            break;
+                        case PS2::Keyboard::Keycode::KEYCODE_F3:
+                            VGA::new_line();
+                            Sync::print_lock_statistics();
+                            break;
+                        case PS2::Keyboard::Keycode::KEYCODE_F4:
+                            VGA::new_line();
+                            Magazine::print_benchmark();
+                            break;
+                        case PS2::Keyboard::Keycode::KEYCODE_F5:
+                            VGA::new_line();
+                            Work::print_queue_stress_test();
+                            break;
+                        case PS2::Keyboard::Keycode::KEYCODE_F6:
+                            VGA::new_line();
+                            Data::print_hash_map_benchmark();
+                            break;
+                        case PS2::Keyboard::Keycode::KEYCODE_F7:
+                            VGA::new_line();
+                            FloppyDisk::print_cache_statistics();
+                            break;
+                        case PS2::Keyboard::Keycode::KEYCODE_F8:
+                            VGA::new_line();
+                            FloppyDisk::print_queue_statistics();
+                            break;
+                        case PS2::Keyboard::Keycode::KEYCODE_F9:
+                            VGA::new_line();
+                            IRQ::print_dispatch_benchmark();
+                            break;
                         default: {
                             const char c = PS2::Keyboard::get_keycode_char(event.key);
                             if (VGA::get_cursor_pos().x < 79 && c != '\0') {
@@ -145,10 +218,35 @@ namespace Kernel {
                     }
                 }
             }
+            Scheduler::yield();
             KERNEL_HALT();
         }
 
         KERNEL_STOP();
     }
 
+    void floppy_thread_main(void* t_argument) {
+        (void)t_argument;
+
+        VGA::put_string("Initializing Floppy Disk... ");
+        if (FloppyDisk::initialize().is_error()) {
+            VGA::put_string("Failed :(\n");
+            return;
+        }
+        VGA::put_string("Done!\n");
+
+        //*
+        u8 buffer[FloppyDisk::SECTOR_SIZE];
+        if (FloppyDisk::read_data(0, 80, 1, buffer).is_error()) {
+            VGA::put_string("Read failed :(\n");
+            return;
+        }
+
+        for (size_t i = 0; i < FloppyDisk::SECTOR_SIZE; i++) {
+            VGA::put_char(buffer[i]);
+        }
+        VGA::new_line();
+        //*/
+    }
+
 }
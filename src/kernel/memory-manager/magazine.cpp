@@ -0,0 +1,354 @@
+#include "magazine.hpp"
+#include "manager.hpp"
+#include "drivers/vga/vga.hpp"
+#include "smp/smp.hpp"
+#include "smp/work.hpp"
+#include "sync/spinlock.hpp"
+
+namespace Kernel::Magazine {
+
+    struct Magazine {
+        Magazine* next; // depot list link
+        u32 roundCount;
+        void* rounds[MAGAZINE_SIZE];
+    };
+
+    // Only touched by its own CPU with interrupts disabled, so it needs no lock
+    struct CPUCache {
+        Magazine* loaded;
+        Magazine* previous;
+    };
+
+    // The lock is only taken with interrupts disabled, an allocation from an IRQ handler could deadlock otherwise
+    struct Depot {
+        Sync::SpinLock lock { "magazine depot" };
+        Magazine* full = nullptr;
+        Magazine* empty = nullptr;
+        size_t fullCount = 0;
+    };
+
+    // Sits in front of every allocation so kfree knows where the memory came from
+    struct AllocationHeader {
+        u32 sizeClass;
+        u32 magic;
+    };
+
+    constexpr u32 LARGE_CLASS = SIZE_CLASS_COUNT;
+    constexpr u32 HEADER_MAGIC = 0x4D41475A;
+
+    static CPUCache s_caches[SMP::MAX_CPU_COUNT][SIZE_CLASS_COUNT];
+    static Depot s_depots[SIZE_CLASS_COUNT];
+    static Statistics s_statistics[SMP::MAX_CPU_COUNT]; // each entry is only written by its own CPU
+    static volatile bool s_enabled = false;
+
+    static u32 get_size_class(size_t t_size) {
+        u32 sizeClass = 0;
+        while ((MIN_CLASS_SIZE << sizeClass) < t_size) {
+            sizeClass++;
+        }
+        return sizeClass;
+    }
+
+    static size_t get_class_size(u32 t_sizeClass) {
+        return MIN_CLASS_SIZE << t_sizeClass;
+    }
+
+    static void push_magazine(Magazine** r_list, Magazine* t_magazine) {
+        t_magazine->next = *r_list;
+        *r_list = t_magazine;
+    }
+
+    static Magazine* pop_magazine(Magazine** r_list) {
+        Magazine* magazine = *r_list;
+        if (magazine != nullptr) {
+            *r_list = magazine->next;
+        }
+        return magazine;
+    }
+
+    // Frees every object in t_magazine to the heap, leaving it empty
+    static void release_rounds(Magazine* t_magazine) {
+        for (u32 i = 0; i < t_magazine->roundCount; i++) {
+            AllocationHeader* header = static_cast<AllocationHeader*>(t_magazine->rounds[i]) - 1;
+            header->magic = 0;
+            (void)MemoryManager::locked_free(header);
+        }
+        t_magazine->roundCount = 0;
+    }
+
+    // Takes an empty magazine from the depot, or makes a new one. Magazines come from the heap directly so this never recurses
+    static Magazine* get_empty_magazine(Depot& t_depot) {
+        t_depot.lock.lock();
+        Magazine* magazine = pop_magazine(&t_depot.empty);
+        t_depot.lock.unlock();
+
+        if (magazine == nullptr) {
+            const auto result = MemoryManager::locked_malloc(sizeof(Magazine));
+            if (result.is_error()) {
+                return nullptr;
+            }
+            magazine = static_cast<Magazine*>(result.get_value());
+            magazine->roundCount = 0;
+        }
+
+        return magazine;
+    }
+
+    // Interrupts must be disabled
+    static void* take_round(size_t t_cpu, u32 t_sizeClass) {
+        CPUCache& cache = s_caches[t_cpu][t_sizeClass];
+
+        if (cache.loaded != nullptr && cache.loaded->roundCount > 0) {
+            return cache.loaded->rounds[--cache.loaded->roundCount];
+        }
+
+        if (cache.previous != nullptr && cache.previous->roundCount > 0) {
+            Magazine* magazine = cache.previous;
+            cache.previous = cache.loaded;
+            cache.loaded = magazine;
+
+            return magazine->rounds[--magazine->roundCount];
+        }
+
+        // Both are empty, trade one of them for a full magazine
+        Depot& depot = s_depots[t_sizeClass];
+        depot.lock.lock();
+        Magazine* full = pop_magazine(&depot.full);
+        if (full != nullptr) {
+            depot.fullCount--;
+            if (cache.previous != nullptr) {
+                push_magazine(&depot.empty, cache.previous);
+            }
+        }
+        depot.lock.unlock();
+
+        if (full == nullptr) {
+            return nullptr;
+        }
+
+        s_statistics[t_cpu].depotExchanges++;
+        cache.previous = cache.loaded;
+        cache.loaded = full;
+
+        return full->rounds[--full->roundCount];
+    }
+
+    // Interrupts must be disabled. Returns false if there was no room and no memory for another magazine
+    static bool put_round(size_t t_cpu, u32 t_sizeClass, void* t_object) {
+        CPUCache& cache = s_caches[t_cpu][t_sizeClass];
+
+        if (cache.loaded != nullptr && cache.loaded->roundCount < MAGAZINE_SIZE) {
+            cache.loaded->rounds[cache.loaded->roundCount++] = t_object;
+            return true;
+        }
+
+        if (cache.previous != nullptr && cache.previous->roundCount == 0) {
+            Magazine* magazine = cache.previous;
+            cache.previous = cache.loaded;
+            cache.loaded = magazine;
+
+            magazine->rounds[magazine->roundCount++] = t_object;
+            return true;
+        }
+
+        // Both are full (or missing), hand the previous one to the depot and load an empty one
+        Depot& depot = s_depots[t_sizeClass];
+        Magazine* empty = get_empty_magazine(depot);
+        if (empty == nullptr) {
+            return false;
+        }
+
+        if (cache.previous != nullptr) {
+            // A depot that already holds enough full magazines doesn't take more, their objects go back to the
+            // heap so a burst of one size doesn't keep its memory from every other size for good
+            depot.lock.lock();
+            const bool hasRoom = (depot.fullCount < MAX_DEPOT_FULL_MAGAZINES);
+            if (hasRoom) {
+                push_magazine(&depot.full, cache.previous);
+                depot.fullCount++;
+            }
+            depot.lock.unlock();
+
+            if (hasRoom) {
+                s_statistics[t_cpu].depotExchanges++;
+            }
+            else {
+                release_rounds(cache.previous);
+
+                depot.lock.lock();
+                push_magazine(&depot.empty, cache.previous);
+                depot.lock.unlock();
+            }
+        }
+
+        cache.previous = cache.loaded;
+        cache.loaded = empty;
+
+        empty->rounds[empty->roundCount++] = t_object;
+        return true;
+    }
+
+    void initialize() {
+        s_enabled = true;
+    }
+
+    void set_enabled(bool t_enabled) {
+        s_enabled = t_enabled;
+
+        if (!t_enabled) {
+            reap();
+        }
+    }
+
+    void reap() {
+        for (u32 sizeClass = 0; sizeClass < SIZE_CLASS_COUNT; sizeClass++) {
+            Depot& depot = s_depots[sizeClass];
+
+            const u32 flags = save_and_disable_interrupts();
+            depot.lock.lock();
+            Magazine* full = depot.full;
+            Magazine* empty = depot.empty;
+            depot.full = nullptr;
+            depot.empty = nullptr;
+            depot.fullCount = 0;
+            depot.lock.unlock();
+            restore_interrupts(flags);
+
+            // Nobody else can see them any more, the heap takes its own lock
+            for (Magazine* magazine = pop_magazine(&full); magazine != nullptr; magazine = pop_magazine(&full)) {
+                release_rounds(magazine);
+                (void)MemoryManager::locked_free(magazine);
+            }
+            for (Magazine* magazine = pop_magazine(&empty); magazine != nullptr; magazine = pop_magazine(&empty)) {
+                (void)MemoryManager::locked_free(magazine);
+            }
+        }
+    }
+
+    Data::ErrorOr<void*> allocate(size_t t_size) {
+        ASSERT(t_size != 0, Error::INVALID_ARGUMENT);
+
+        const u32 sizeClass = (t_size <= MAX_CLASS_SIZE) ? get_size_class(t_size) : LARGE_CLASS;
+
+        if (sizeClass != LARGE_CLASS && s_enabled) {
+            const u32 flags = save_and_disable_interrupts();
+            const size_t cpu = SMP::get_current_cpu_index();
+            void* object = take_round(cpu, sizeClass);
+            if (object != nullptr) {
+                s_statistics[cpu].hits++;
+            }
+            else {
+                s_statistics[cpu].misses++;
+            }
+            restore_interrupts(flags);
+
+            if (object != nullptr) {
+                return object;
+            }
+        }
+
+        // Class sized allocations are padded so they can be cached once freed
+        const size_t size = (sizeClass == LARGE_CLASS) ? t_size : get_class_size(sizeClass);
+        auto memory = MemoryManager::locked_malloc(sizeof(AllocationHeader) + size);
+        if (memory.is_error()) {
+            // The heap may be short of exactly the memory that sits cached in the depots
+            reap();
+            memory = MemoryManager::locked_malloc(sizeof(AllocationHeader) + size);
+        }
+        AllocationHeader* header = static_cast<AllocationHeader*>(TRY(memory));
+        *header = AllocationHeader { sizeClass, HEADER_MAGIC };
+
+        return header + 1;
+    }
+
+    Data::ErrorOr<void> free(void* t_memory) {
+        if (t_memory == nullptr) {
+            return Data::ErrorOr<void>();
+        }
+
+        AllocationHeader* header = static_cast<AllocationHeader*>(t_memory) - 1;
+        ASSERT(header->magic == HEADER_MAGIC, Error::INVALID_ARGUMENT);
+
+        if (header->sizeClass != LARGE_CLASS && s_enabled) {
+            const u32 flags = save_and_disable_interrupts();
+            const bool cached = put_round(SMP::get_current_cpu_index(), header->sizeClass, t_memory);
+            restore_interrupts(flags);
+
+            if (cached) {
+                return Data::ErrorOr<void>();
+            }
+        }
+
+        header->magic = 0;
+        return MemoryManager::locked_free(header);
+    }
+
+    Statistics get_statistics(size_t t_cpu) {
+        return s_statistics[t_cpu];
+    }
+
+    // Each element is a burst of allocations of mixed sizes that are then freed in reverse order
+    void alloc_free_range(size_t t_begin, size_t t_end, void* t_context) {
+        (void)t_context;
+
+        constexpr size_t BURST_SIZE = 8;
+        void* objects[BURST_SIZE];
+
+        for (size_t i = t_begin; i < t_end; i++) {
+            for (size_t j = 0; j < BURST_SIZE; j++) {
+                objects[j] = kmalloc(MIN_CLASS_SIZE << (j % 5));
+            }
+            for (size_t j = BURST_SIZE; j > 0; j--) {
+                kfree(objects[j - 1]);
+            }
+        }
+    }
+
+    void print_benchmark() {
+        constexpr size_t BURST_COUNT = 4096;
+        constexpr size_t GRAIN_SIZE = 64;
+
+        VGA::put_string("kmalloc/kfree of 32K objects\n----------------------------\n");
+
+        const size_t previousActiveCount = Work::get_active_cpu_count();
+        const bool previousEnabled = s_enabled;
+
+        for (size_t cpuCount = 1; cpuCount <= SMP::get_online_cpu_count(); cpuCount++) {
+            Work::set_active_cpu_count(cpuCount);
+
+            VGA::put_unsigned_decimal(cpuCount);
+            VGA::put_string(" CPU(s): ");
+
+            for (size_t pass = 0; pass < 2; pass++) {
+                const bool enabled = (pass == 1);
+                set_enabled(enabled);
+
+                const u64 start = read_timestamp_counter();
+                Work::parallel_for(0, BURST_COUNT, GRAIN_SIZE, alloc_free_range, nullptr);
+                const u64 cycles = read_timestamp_counter() - start;
+
+                VGA::put_string(enabled ? ", magazines " : "heap ");
+                VGA::put_unsigned_decimal(static_cast<u32>(cycles / 1000));
+                VGA::put_string(" kcycles");
+            }
+            VGA::new_line();
+        }
+
+        set_enabled(previousEnabled);
+        Work::set_active_cpu_count(previousActiveCount);
+
+        for (size_t cpu = 0; cpu < SMP::get_cpu_count(); cpu++) {
+            VGA::put_string("CPU ");
+            VGA::put_unsigned_decimal(cpu);
+            VGA::put_string(": ");
+            VGA::put_unsigned_decimal(s_statistics[cpu].hits);
+            VGA::put_string(" hits, ");
+            VGA::put_unsigned_decimal(s_statistics[cpu].misses);
+            VGA::put_string(" misses, ");
+            VGA::put_unsigned_decimal(s_statistics[cpu].depotExchanges);
+            VGA::put_string(" depot exchanges\n");
+        }
+        VGA::new_line();
+    }
+
+}
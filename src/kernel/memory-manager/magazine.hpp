@@ -0,0 +1,51 @@
+#ifndef KERNEL_MAGAZINE_INCLUDED
+#define KERNEL_MAGAZINE_INCLUDED
+
+#include "common.hpp"
+#include "data/error_or.hpp"
+
+namespace Kernel::Magazine {
+
+    // Per-CPU object caches in front of the heap (Bonwick & Adams, "Magazines and Vmem").
+    // Small allocations are rounded up to a size class, and each CPU keeps a loaded and a previous magazine
+    // (a stack of free objects) per class, so most kmalloc/kfree calls never take the heap lock or touch
+    // another CPU's cache lines. Full and empty magazines are swapped with a per-class depot when both run out.
+
+    constexpr size_t MAGAZINE_SIZE = 15; // objects per magazine
+
+    // Full magazines a class's depot keeps, the objects in any more than that go back to the heap
+    constexpr size_t MAX_DEPOT_FULL_MAGAZINES = 8;
+
+    // Classes are 16, 32, ..., 2048 bytes, anything bigger goes straight to the heap
+    constexpr size_t MIN_CLASS_SIZE = 16;
+    constexpr size_t SIZE_CLASS_COUNT = 8;
+    constexpr size_t MAX_CLASS_SIZE = MIN_CLASS_SIZE << (SIZE_CLASS_COUNT - 1);
+
+    struct Statistics {
+        u32 hits; // served from the CPU's own magazines
+        u32 misses; // went to the heap
+        u32 depotExchanges;
+    };
+
+    // Turns the caches on, until then every allocation goes to the heap. Needs the boot CPU's per-CPU data
+    void initialize();
+
+    // Used by the benchmark to compare against the bare heap, objects that are already cached stay valid.
+    // Disabling reaps the depots
+    void set_enabled(bool t_enabled);
+
+    // Hands every magazine in the depots and the objects in them back to the heap. The CPUs' own magazines stay.
+    // allocate does this before it fails for lack of heap memory
+    void reap();
+
+    Data::ErrorOr<void*> allocate(size_t t_size);
+    Data::ErrorOr<void> free(void* t_memory);
+
+    Statistics get_statistics(size_t t_cpu);
+
+    // Times alloc/free pairs with 1 to N active CPUs, with and without the magazines
+    void print_benchmark();
+
+}
+
+#endif
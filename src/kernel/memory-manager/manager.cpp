@@ -1,8 +1,10 @@
 #include "data/fc_vector.hpp"
 
 #include "common.hpp"
+#include "magazine.hpp"
 #include "manager.hpp"
 #include "drivers/vga/vga.hpp"
+#include "sync/spinlock.hpp"
 
 namespace Kernel::MemoryManager {
 
@@ -40,6 +42,9 @@ namespace Kernel::MemoryManager {
 
     static MemoryInfo s_memoryInfo;
     static MemoryRangeTable s_memoryRangeTable;
+
+    // Guards s_memoryInfo, and keeps the timer from switching threads half way through updating the block list
+    static Sync::IRQSpinLock s_heapLock("heap");
     
 
     void initialize_memory_range();
@@ -143,6 +148,22 @@ namespace Kernel::MemoryManager {
         return Data::ErrorOr<void>();
     }
 
+    Data::ErrorOr<void*> locked_malloc(size_t t_size) {
+        s_heapLock.lock();
+        Data::ErrorOr<void*> result = malloc(t_size);
+        s_heapLock.unlock();
+
+        return result;
+    }
+
+    Data::ErrorOr<void> locked_free(void* t_memory) {
+        s_heapLock.lock();
+        Data::ErrorOr<void> result = free(t_memory);
+        s_heapLock.unlock();
+
+        return result;
+    }
+
     void print_heap_information() {
         VGA::put_string("Blocks\n");
         VGA::put_string("------\n");
@@ -270,7 +291,8 @@ namespace Kernel::MemoryManager {
 namespace Kernel {
 
     void* kmalloc(size_t t_size) {
-        Data::ErrorOr<void*> result = Kernel::MemoryManager::malloc(t_size);
+        Data::ErrorOr<void*> result = Magazine::allocate(t_size);
+
         if (result.is_error()) {
             MemoryManager::print_heap_information();
             VGA::put_string("Failed to allocate memory of size: ");
@@ -284,7 +306,7 @@ namespace Kernel {
     }
 
     void kfree(void* t_memory) {
-        Data::ErrorOr<void> result = Kernel::MemoryManager::free(t_memory);
+        Data::ErrorOr<void> result = Magazine::free(t_memory);
 
         if (result.is_error()) {
             MemoryManager::print_heap_information();
@@ -11,6 +11,10 @@ namespace Kernel::MemoryManager {
     Data::ErrorOr<void*> malloc(size_t t_size);
     Data::ErrorOr<void> free(void* t_memory);
 
+    // malloc and free under the heap lock, safe to call from any CPU
+    Data::ErrorOr<void*> locked_malloc(size_t t_size);
+    Data::ErrorOr<void> locked_free(void* t_memory);
+
     void print_memory_range_information();
     void print_heap_information();
 }
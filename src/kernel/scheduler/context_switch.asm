@@ -0,0 +1,28 @@
+; void context_switch(u32* r_oldStackPointer, u32 t_newStackPointer)
+;
+; Pushes the callee-saved registers and EFLAGS onto the current stack, stores the
+; stack pointer in *r_oldStackPointer and pops the same layout off t_newStackPointer.
+; The caller-saved registers have already been preserved by the C++ caller.
+
+SECTION .text
+
+global context_switch
+context_switch:
+    mov eax, [esp + 4]      ; r_oldStackPointer
+    mov edx, [esp + 8]      ; t_newStackPointer
+
+    push ebp
+    push ebx
+    push esi
+    push edi
+    pushfd
+
+    mov [eax], esp
+    mov esp, edx
+
+    popfd
+    pop edi
+    pop esi
+    pop ebx
+    pop ebp
+    ret
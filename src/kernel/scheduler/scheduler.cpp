@@ -0,0 +1,293 @@
+#include "scheduler.hpp"
+#include "wait_queue.hpp"
+#include "drivers/pit/pit.hpp"
+#include "interrupts/irq.hpp"
+#include "memory-manager/manager.hpp"
+
+namespace Kernel::Scheduler {
+
+    extern "C" void context_switch(u32* r_oldStackPointer, u32 t_newStackPointer);
+
+    constexpr bool tick_reached(uint t_now, uint t_tick) {
+        return static_cast<s32>(t_now - t_tick) >= 0;
+    }
+
+    // Tick counts wrap, which is fine as long as no timeout is more than 2^31 ticks away
+    struct WakeOrder {
+        static bool less(const Thread& t_a, const Thread& t_b) {
+            return !tick_reached(t_a.wakeTick, t_b.wakeTick);
+        }
+    };
+
+    static struct {
+        Thread* currentThread;
+        Thread* previousThread; // thread that was switched away from, read by the thread switched to
+        Thread* idleThread;     // only runs when nothing else can, never sits in the run queue
+
+        Data::IntrusiveList<Thread, &Thread::queueNode> runQueue;
+        Data::RBTree<Thread, &Thread::sleepNode, WakeOrder> sleepQueue; // blocked threads with a timeout
+
+        uint timeSliceRemaining;
+        bool needsReschedule;
+
+        u32 nextThreadId;
+    } s_schedulerState;
+
+    void timer_tick(void* t_context);
+
+    void schedule();
+    void finish_switch();
+
+    [[noreturn]] void thread_entry();
+    void idle_thread_main(void* t_argument);
+
+    Data::ErrorOr<Thread*> allocate_thread(const char* t_name, ThreadFunction t_function, void* t_argument);
+
+    void enqueue(Thread* t_thread);
+    void enqueue_front(Thread* t_thread);
+    Thread* dequeue();
+
+    void add_sleeping_thread(Thread* t_thread);
+    void remove_sleeping_thread(Thread* t_thread);
+
+    Data::ErrorOr<void> initialize() {
+        Thread* bootThread = new Thread;
+        bootThread->state = ThreadState::RUNNING;
+        bootThread->name = "kernel_main";
+        bootThread->id = s_schedulerState.nextThreadId++;
+
+        s_schedulerState.idleThread = TRY(allocate_thread("idle", idle_thread_main, nullptr));
+
+        s_schedulerState.currentThread = bootThread;
+        s_schedulerState.timeSliceRemaining = TIME_SLICE_TICKS;
+
+        TRY(IRQ::register_handler(IRQ::LINE_TIMER, timer_tick, nullptr));
+
+        return Data::ErrorOr<void>();
+    }
+
+    bool is_initialized() {
+        return s_schedulerState.currentThread != nullptr;
+    }
+
+    Data::ErrorOr<Thread*> create_thread(const char* t_name, ThreadFunction t_function, void* t_argument) {
+        ASSERT(is_initialized(), Error::UNINITIALIZED);
+
+        Thread* thread = TRY(allocate_thread(t_name, t_function, t_argument));
+
+        const u32 flags = save_and_disable_interrupts();
+        enqueue(thread);
+        restore_interrupts(flags);
+
+        return thread;
+    }
+
+    void yield() {
+        if (!is_initialized()) {
+            return;
+        }
+
+        const u32 flags = save_and_disable_interrupts();
+        schedule();
+        restore_interrupts(flags);
+    }
+
+    void exit_thread() {
+        disable_interrupts();
+
+        s_schedulerState.currentThread->state = ThreadState::DEAD;
+        schedule();
+
+        // Unreachable, the idle thread is always there to switch to
+        KERNEL_STOP();
+        while (true) {}
+    }
+
+    Thread* get_current_thread() {
+        return s_schedulerState.currentThread;
+    }
+
+    void preempt_if_needed() {
+        if (s_schedulerState.needsReschedule) {
+            schedule();
+        }
+    }
+
+    void sleep(uint t_ticks) {
+        if (t_ticks == 0) {
+            return;
+        }
+
+        const u32 flags = save_and_disable_interrupts();
+        block_current_thread(t_ticks);
+        restore_interrupts(flags);
+    }
+
+    bool block_current_thread(uint t_timeoutTicks) {
+        Thread* thread = s_schedulerState.currentThread;
+
+        thread->state = ThreadState::BLOCKED;
+        thread->timedOut = false;
+        if (t_timeoutTicks != 0) {
+            thread->wakeTick = PIT::get_ticks() + t_timeoutTicks;
+            add_sleeping_thread(thread);
+        }
+
+        schedule();
+
+        return !thread->timedOut;
+    }
+
+    void wake_thread(Thread* t_thread) {
+        if (t_thread->state != ThreadState::BLOCKED) {
+            return;
+        }
+
+        if (t_thread->sleeping) {
+            remove_sleeping_thread(t_thread);
+        }
+        if (t_thread->waitQueue != nullptr) {
+            t_thread->waitQueue->remove(t_thread);
+        }
+
+        // Woken threads go to the front so an IRQ completion is handled straight after the interrupt returns
+        t_thread->state = ThreadState::READY;
+        enqueue_front(t_thread);
+        s_schedulerState.needsReschedule = true;
+    }
+
+    void timer_tick(void* t_context) {
+        (void)t_context;
+
+        const uint now = PIT::get_ticks();
+        for (Thread* thread = s_schedulerState.sleepQueue.first(); thread != nullptr && tick_reached(now, thread->wakeTick); thread = s_schedulerState.sleepQueue.first()) {
+            thread->timedOut = true;
+            wake_thread(thread);
+        }
+
+        if (s_schedulerState.timeSliceRemaining > 0) {
+            s_schedulerState.timeSliceRemaining--;
+        }
+        if (s_schedulerState.timeSliceRemaining == 0) {
+            s_schedulerState.needsReschedule = true;
+        }
+    }
+
+    // Must be called with interrupts disabled
+    void schedule() {
+        Thread* previous = s_schedulerState.currentThread;
+        Thread* idle = s_schedulerState.idleThread;
+
+        s_schedulerState.timeSliceRemaining = TIME_SLICE_TICKS;
+        s_schedulerState.needsReschedule = false;
+
+        if (previous->state == ThreadState::RUNNING && previous != idle) {
+            if (s_schedulerState.runQueue.is_empty()) {
+                return; // nothing else to run so keep going
+            }
+            previous->state = ThreadState::READY;
+            enqueue(previous);
+        }
+
+        Thread* next = dequeue();
+        if (next == nullptr) {
+            next = idle;
+        }
+        if (next == previous) {
+            return;
+        }
+
+        if (previous == idle) {
+            idle->state = ThreadState::READY;
+        }
+        next->state = ThreadState::RUNNING;
+        s_schedulerState.currentThread = next;
+        s_schedulerState.previousThread = previous;
+
+        context_switch(&previous->stackPointer, next->stackPointer);
+
+        // We are now running as whichever thread was switched back to
+        finish_switch();
+    }
+
+    void finish_switch() {
+        Thread* previous = s_schedulerState.previousThread;
+        s_schedulerState.previousThread = nullptr;
+
+        // A dead thread's stack can only be released once we are off it
+        if (previous != nullptr && previous->state == ThreadState::DEAD) {
+            delete[] previous->stackBase;
+            delete previous;
+        }
+    }
+
+    void thread_entry() {
+        finish_switch();
+        enable_interrupts();
+
+        Thread* thread = s_schedulerState.currentThread;
+        thread->function(thread->argument);
+
+        exit_thread();
+    }
+
+    void idle_thread_main(void* t_argument) {
+        (void)t_argument;
+
+        while (true) {
+            KERNEL_HALT();
+        }
+    }
+
+    Data::ErrorOr<Thread*> allocate_thread(const char* t_name, ThreadFunction t_function, void* t_argument) {
+        ASSERT(t_function != nullptr, Error::INVALID_ARGUMENT);
+
+        u8* stackBase = new u8[THREAD_STACK_SIZE];
+
+        // Build the frame context_switch expects so that the first switch "returns" into thread_entry
+        u32* stackPointer = reinterpret_cast<u32*>(stackBase + THREAD_STACK_SIZE);
+        *--stackPointer = 0;                                      // return address of thread_entry (never used)
+        *--stackPointer = reinterpret_cast<uintptr_t>(thread_entry);
+        *--stackPointer = 0;                                      // ebp
+        *--stackPointer = 0;                                      // ebx
+        *--stackPointer = 0;                                      // esi
+        *--stackPointer = 0;                                      // edi
+        *--stackPointer = 0x002;                                  // eflags, interrupts stay off until thread_entry
+
+        Thread* thread = new Thread;
+        thread->stackPointer = reinterpret_cast<uintptr_t>(stackPointer);
+        thread->stackBase = stackBase;
+        thread->function = t_function;
+        thread->argument = t_argument;
+        thread->name = t_name;
+
+        const u32 flags = save_and_disable_interrupts();
+        thread->id = s_schedulerState.nextThreadId++;
+        restore_interrupts(flags);
+
+        return thread;
+    }
+
+    void enqueue(Thread* t_thread) {
+        s_schedulerState.runQueue.push_back(*t_thread);
+    }
+
+    void enqueue_front(Thread* t_thread) {
+        s_schedulerState.runQueue.push_front(*t_thread);
+    }
+
+    Thread* dequeue() {
+        return s_schedulerState.runQueue.pop_front();
+    }
+
+    void add_sleeping_thread(Thread* t_thread) {
+        s_schedulerState.sleepQueue.insert(*t_thread);
+        t_thread->sleeping = true;
+    }
+
+    void remove_sleeping_thread(Thread* t_thread) {
+        s_schedulerState.sleepQueue.remove(*t_thread);
+        t_thread->sleeping = false;
+    }
+
+}
@@ -0,0 +1,76 @@
+#ifndef SCHEDULER_INCLUDED
+#define SCHEDULER_INCLUDED
+
+#include "common.hpp"
+#include "data/error_or.hpp"
+#include "data/intrusive_list.hpp"
+#include "data/rb_tree.hpp"
+
+namespace Kernel::Scheduler {
+
+    class WaitQueue;
+
+    using ThreadFunction = void (*)(void* t_argument);
+
+    enum class ThreadState {
+        READY,
+        RUNNING,
+        BLOCKED,
+        DEAD
+    };
+
+    struct Thread {
+        u32 stackPointer = 0;     // saved by context_switch while the thread is not running
+        u8* stackBase = nullptr;  // nullptr for the boot thread which runs on g_stack
+        ThreadState state = ThreadState::READY;
+
+        ThreadFunction function = nullptr;
+        void* argument = nullptr;
+
+        const char* name = nullptr;
+        u32 id = 0;
+
+        Data::IntrusiveListNode queueNode; // run queue or wait queue link
+
+        WaitQueue* waitQueue = nullptr; // wait queue the thread is blocked on, if any
+        Data::RBTreeNode sleepNode;     // timeout tree link
+        uint wakeTick = 0;
+        bool sleeping = false;
+        bool timedOut = false;
+    };
+
+    constexpr size_t THREAD_STACK_SIZE = 8192;
+    constexpr uint TIME_SLICE_TICKS = 10;
+
+    // Turns the calling context into the first thread and starts preempting on the timer IRQ, needs the heap
+    Data::ErrorOr<void> initialize();
+
+    [[nodiscard]] bool is_initialized();
+
+    Data::ErrorOr<Thread*> create_thread(const char* t_name, ThreadFunction t_function, void* t_argument);
+
+    // Gives up the rest of the time slice if another thread is ready to run
+    void yield();
+
+    [[noreturn]] void exit_thread();
+
+    Thread* get_current_thread();
+
+    // Called by the IRQ dispatcher on its way out, switches thread if the time slice has run out or a thread was woken
+    void preempt_if_needed();
+
+    // Blocks the current thread for at least t_ticks timer ticks
+    void sleep(uint t_ticks);
+
+    // The following must be called with interrupts disabled
+
+    // Blocks the current thread until wake_thread is called or t_timeoutTicks pass (0 waits forever),
+    // returns false if the timeout expired first
+    bool block_current_thread(uint t_timeoutTicks);
+
+    // Makes a blocked thread runnable again and switches to it as soon as the current IRQ (if any) returns
+    void wake_thread(Thread* t_thread);
+
+}
+
+#endif
@@ -0,0 +1,48 @@
+#include "wait_queue.hpp"
+
+namespace Kernel::Scheduler {
+
+    Data::ErrorOr<void> WaitQueue::wait(uint t_timeoutTicks) {
+        ASSERT(is_initialized(), Error::UNINITIALIZED);
+
+        Thread* thread = get_current_thread();
+
+        thread->waitQueue = this;
+        m_threads.push_back(*thread);
+
+        if (!block_current_thread(t_timeoutTicks)) {
+            return Error::TIMED_OUT;
+        }
+
+        return Data::ErrorOr<void>();
+    }
+
+    bool WaitQueue::wake_one() {
+        const u32 flags = save_and_disable_interrupts();
+
+        Thread* thread = m_threads.front();
+        if (thread != nullptr) {
+            wake_thread(thread); // removes it from this queue
+        }
+
+        restore_interrupts(flags);
+
+        return thread != nullptr;
+    }
+
+    void WaitQueue::wake_all() {
+        const u32 flags = save_and_disable_interrupts();
+
+        while (!m_threads.is_empty()) {
+            wake_thread(m_threads.front());
+        }
+
+        restore_interrupts(flags);
+    }
+
+    void WaitQueue::remove(Thread* t_thread) {
+        m_threads.remove(*t_thread);
+        t_thread->waitQueue = nullptr;
+    }
+
+}
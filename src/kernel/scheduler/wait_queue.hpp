@@ -0,0 +1,39 @@
+#ifndef WAIT_QUEUE_INCLUDED
+#define WAIT_QUEUE_INCLUDED
+
+#include "common.hpp"
+#include "data/error_or.hpp"
+#include "scheduler.hpp"
+
+namespace Kernel::Scheduler {
+
+    // FIFO of blocked threads. Callers disable interrupts, check their wake-up condition, and only
+    // then call wait, so a wake from an IRQ handler can't slip in between the check and the block.
+    class WaitQueue {
+    public:
+        constexpr WaitQueue() {
+            ;
+        }
+
+        // Must be called with interrupts disabled, they are still disabled when it returns.
+        // t_timeoutTicks = 0 waits forever
+        Data::ErrorOr<void> wait(uint t_timeoutTicks = 0);
+
+        // Safe to call from interrupt handlers, return true if a thread was woken
+        bool wake_one();
+        void wake_all();
+
+        [[nodiscard]] bool is_empty() const {
+            return m_threads.is_empty();
+        }
+
+        // Used by the scheduler when a waiting thread times out
+        void remove(Thread* t_thread);
+
+    private:
+        Data::IntrusiveList<Thread, &Thread::queueNode> m_threads;
+    };
+
+}
+
+#endif
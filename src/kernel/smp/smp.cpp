@@ -0,0 +1,136 @@
+#include "smp.hpp"
+#include "acpi/acpi.hpp"
+#include "drivers/vga/vga.hpp"
+#include "interrupts/idt.hpp"
+#include "interrupts/lapic.hpp"
+#include "work.hpp"
+
+namespace Kernel::SMP {
+
+    // Must match smp/trampoline.asm, below 1MiB and page aligned so a STARTUP IPI can point at it
+    constexpr uintptr_t TRAMPOLINE_ADDRESS = 0x8000;
+    constexpr u8 TRAMPOLINE_VECTOR = TRAMPOLINE_ADDRESS >> 12;
+
+    constexpr uint INIT_WAIT_TIME = 10;     // 10ms
+    constexpr uint STARTUP_WAIT_TIME = 1;   // 1ms, at least 200us is needed
+    constexpr uint ONLINE_TIMEOUT = 100;    // 100ms
+    constexpr size_t STARTUP_ATTEMPT_COUNT = 2;
+
+    struct TrampolineParameters {
+        u32 stackTop;
+        u32 entry;
+        u32 argument;
+    };
+
+    extern "C" u8 smp_trampoline_start[];
+    extern "C" u8 smp_trampoline_end[];
+    extern "C" u8 smp_trampoline_parameters[];
+
+    extern "C" [[noreturn]] void smp_application_processor_main(CPU* t_cpu);
+
+    static CPU s_cpus[MAX_CPU_COUNT];
+    static u8 s_cpuStacks[MAX_CPU_COUNT - 1][CPU_STACK_SIZE] __attribute__((aligned(16))); // the BSP keeps g_stack
+
+    static struct {
+        size_t cpuCount;
+        size_t onlineCount;
+    } s_smpState = { 1, 1 };
+
+    void initialize_cpu(size_t t_index, u8 t_apicId) {
+        CPU& cpu = s_cpus[t_index];
+
+        cpu.self = &cpu;
+        cpu.index = t_index;
+        cpu.apicId = t_apicId;
+        cpu.online = false;
+
+        GDT::initialize_cpu_table(cpu.gdt, reinterpret_cast<u32>(&cpu), sizeof(CPU));
+    }
+
+    void initialize_boot_cpu() {
+        initialize_cpu(0, 0);
+        s_cpus[0].online = true;
+
+        GDT::load_cpu_table(s_cpus[0].gdt);
+    }
+
+    Data::ErrorOr<void> start_cpu(CPU& t_cpu) {
+        TrampolineParameters* parameters = reinterpret_cast<TrampolineParameters*>(
+            TRAMPOLINE_ADDRESS + (smp_trampoline_parameters - smp_trampoline_start)
+        );
+        parameters->stackTop = reinterpret_cast<u32>(s_cpuStacks[t_cpu.index - 1] + CPU_STACK_SIZE);
+        parameters->entry = reinterpret_cast<u32>(smp_application_processor_main);
+        parameters->argument = reinterpret_cast<u32>(&t_cpu);
+
+        // INIT-SIPI-SIPI, the second STARTUP is only sent if the first one didn't take
+        TRY(LAPIC::send_init(t_cpu.apicId));
+        sleep(INIT_WAIT_TIME);
+
+        for (size_t i = 0; i < STARTUP_ATTEMPT_COUNT && !t_cpu.online; i++) {
+            TRY(LAPIC::send_startup(t_cpu.apicId, TRAMPOLINE_VECTOR));
+            sleep(STARTUP_WAIT_TIME);
+        }
+
+        for (uint i = 0; i < ONLINE_TIMEOUT && !t_cpu.online; i++) {
+            sleep(1);
+        }
+        ASSERT(t_cpu.online, Error::TIMED_OUT);
+
+        return Data::ErrorOr<void>();
+    }
+
+    Data::ErrorOr<void> start_application_processors() {
+        const ACPI::ProcessorInfo info = TRY(ACPI::get_processor_info());
+        LAPIC::set_base_address(info.localAPICAddress);
+
+        const u8 bootAPICId = LAPIC::get_id();
+        s_cpus[0].apicId = bootAPICId;
+
+        memcpy(reinterpret_cast<void*>(TRAMPOLINE_ADDRESS), smp_trampoline_start, smp_trampoline_end - smp_trampoline_start);
+
+        for (size_t i = 0; i < info.processorCount && s_smpState.cpuCount < MAX_CPU_COUNT; i++) {
+            if (info.apicIds[i] == bootAPICId) {
+                continue;
+            }
+
+            CPU& cpu = s_cpus[s_smpState.cpuCount];
+            initialize_cpu(s_smpState.cpuCount, info.apicIds[i]);
+
+            // A processor that timed out may still be on its way through the trampoline, so reusing the
+            // parameter block for the next one could hand out the same stack twice. It isn't counted either way
+            if (start_cpu(cpu).is_error()) {
+                VGA::put_string("CPU ");
+                VGA::put_unsigned_decimal(cpu.index);
+                VGA::put_string(" failed to start\n");
+                break;
+            }
+            s_smpState.cpuCount++;
+            s_smpState.onlineCount++;
+        }
+
+        return Data::ErrorOr<void>();
+    }
+
+    size_t get_cpu_count() {
+        return s_smpState.cpuCount;
+    }
+
+    size_t get_online_cpu_count() {
+        return s_smpState.onlineCount;
+    }
+
+    CPU& get_cpu(size_t t_index) {
+        return s_cpus[t_index];
+    }
+
+    void smp_application_processor_main(CPU* t_cpu) {
+        GDT::load_cpu_table(t_cpu->gdt);
+        IDT::load_table();
+        LAPIC::enable();
+
+        t_cpu->online = true;
+
+        Work::run_idle_loop();
+    }
+
+}
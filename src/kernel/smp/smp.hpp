@@ -0,0 +1,47 @@
+#ifndef SMP_INCLUDED
+#define SMP_INCLUDED
+
+#include "common.hpp"
+#include "gdt.hpp"
+#include "data/error_or.hpp"
+
+namespace Kernel::SMP {
+
+    constexpr size_t MAX_CPU_COUNT = 8;
+    constexpr size_t CPU_STACK_SIZE = 8192;
+
+    // Per-CPU block, GS is based at it on every CPU
+    struct CPU {
+        CPU* self; // must stay first, get_current_cpu reads it through GS
+        u32 index;
+        u8 apicId;
+        volatile bool online;
+
+        GDT::CPUTable gdt;
+    };
+
+    // Moves the bootstrap processor onto its own GDT so that get_current_cpu works, call right after the GDT is set up
+    void initialize_boot_cpu();
+
+    // Finds the other processors in the MADT and starts each one into an idle loop, needs the timer IRQ running
+    Data::ErrorOr<void> start_application_processors();
+
+    // CPUs that have started, the boot CPU included. A processor listed in the MADT that didn't start isn't counted
+    [[nodiscard]] size_t get_cpu_count();
+    [[nodiscard]] size_t get_online_cpu_count();
+
+    CPU& get_cpu(size_t t_index);
+
+    inline CPU* get_current_cpu() {
+        CPU* cpu;
+        asm volatile ("movl %%gs:0, %0" : "=r" (cpu));
+        return cpu;
+    }
+
+    inline u32 get_current_cpu_index() {
+        return get_current_cpu()->index;
+    }
+
+}
+
+#endif
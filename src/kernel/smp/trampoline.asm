@@ -0,0 +1,66 @@
+; Application processor start-up code.
+;
+; The BSP copies everything between smp_trampoline_start and smp_trampoline_end to
+; TRAMPOLINE_ADDRESS (which must match smp.cpp) and sends a STARTUP IPI pointing at it.
+; The AP starts here in real mode, switches to protected mode with a temporary flat GDT,
+; loads the stack from the parameter block and calls entry(argument). The entry point
+; loads the CPU's own GDT and never returns.
+
+TRAMPOLINE_ADDRESS equ 0x8000
+
+%define TRAMPOLINE_RELOCATE(label) (TRAMPOLINE_ADDRESS + ((label) - smp_trampoline_start))
+
+SECTION .text
+
+global smp_trampoline_start
+global smp_trampoline_end
+global smp_trampoline_parameters
+
+[bits 16]
+smp_trampoline_start:
+    cli
+    cld
+    xor ax, ax
+    mov ds, ax
+
+    o32 lgdt [TRAMPOLINE_RELOCATE(trampoline_gdt_descriptor)]
+
+    mov eax, cr0
+    or eax, 1               ; protected mode enable
+    mov cr0, eax
+
+    jmp dword 0x08:TRAMPOLINE_RELOCATE(trampoline_protected_mode)
+
+[bits 32]
+trampoline_protected_mode:
+    mov ax, 0x10
+    mov ds, ax
+    mov es, ax
+    mov fs, ax
+    mov gs, ax
+    mov ss, ax
+
+    mov esp, [TRAMPOLINE_RELOCATE(trampoline_stack_top)]
+    push dword [TRAMPOLINE_RELOCATE(trampoline_argument)]
+    push dword 0            ; entry never returns
+    jmp [TRAMPOLINE_RELOCATE(trampoline_entry)]
+
+align 8
+trampoline_gdt:
+    dw 0x0000, 0x0000, 0x0000, 0x0000 ; NULL
+    dw 0xFFFF, 0x0000, 0x9A00, 0x00CF ; KERNEL_CODE
+    dw 0xFFFF, 0x0000, 0x9200, 0x00CF ; KERNEL_DATA
+trampoline_gdt_end:
+
+trampoline_gdt_descriptor:
+    dw trampoline_gdt_end - trampoline_gdt - 1
+    dd TRAMPOLINE_RELOCATE(trampoline_gdt)
+
+; Filled in by the BSP before each AP is started
+align 4
+smp_trampoline_parameters:
+trampoline_stack_top: dd 0
+trampoline_entry:     dd 0
+trampoline_argument:  dd 0
+
+smp_trampoline_end:
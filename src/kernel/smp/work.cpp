@@ -0,0 +1,337 @@
+#include "work.hpp"
+#include "smp.hpp"
+#include "data/mpmc_queue.hpp"
+#include "data/work_stealing_deque.hpp"
+#include "drivers/vga/vga.hpp"
+#include "interrupts/idt.hpp"
+#include "interrupts/interrupt_handler.hpp"
+#include "interrupts/lapic.hpp"
+#include "memory-manager/manager.hpp"
+
+namespace Kernel::Work {
+
+    using Deque = Data::WorkStealingDeque<Job*, DEQUE_SIZE>;
+
+    static Deque s_deques[SMP::MAX_CPU_COUNT];
+    static Statistics s_statistics[SMP::MAX_CPU_COUNT]; // each entry is only written by its own CPU
+
+    static volatile struct {
+        size_t activeCPUCount;
+        u32 idleCount; // CPUs halted in run_idle_loop
+    } s_workState = { SMP::MAX_CPU_COUNT, 0 };
+
+    INTERRUPT_HANDLER void wake_handler(InterruptHandler::InterruptFrame* t_frame);
+
+    void initialize() {
+        IDT::set_entry(WAKE_VECTOR, (void*)&wake_handler, GDT::KERNEL_CODE_SELECTOR, IDT::IDTGateType::INTERRUPT, true);
+    }
+
+    size_t get_participating_cpu_count() {
+        const size_t online = SMP::get_cpu_count();
+        return (s_workState.activeCPUCount < online) ? s_workState.activeCPUCount : online;
+    }
+
+    // Interrupts are disabled around the owner's end of the deque, so a thread switch or IRQ on the same CPU can't interleave
+    Data::ErrorOr<void> push_local(Job* t_job) {
+        const u32 flags = save_and_disable_interrupts();
+        const auto result = s_deques[SMP::get_current_cpu_index()].push(t_job);
+        restore_interrupts(flags);
+
+        return result;
+    }
+
+    void wake_idle_cpus() {
+        // Pairs with the increment in run_idle_loop: either the halting CPU sees the new job or we see it halting
+        __atomic_thread_fence(__ATOMIC_SEQ_CST);
+        if (s_workState.idleCount != 0) {
+            (void)LAPIC::send_to_others(WAKE_VECTOR);
+        }
+    }
+
+    Data::ErrorOr<void> submit(Job* t_job) {
+        ASSERT(t_job != nullptr && t_job->function != nullptr, Error::INVALID_ARGUMENT);
+
+        TRY(push_local(t_job));
+        wake_idle_cpus();
+
+        return Data::ErrorOr<void>();
+    }
+
+    Job* find_job(u32 t_cpu) {
+        const u32 flags = save_and_disable_interrupts();
+        const auto own = s_deques[t_cpu].pop();
+        restore_interrupts(flags);
+
+        if (!own.is_error()) {
+            return own.get_value();
+        }
+
+        const size_t cpuCount = get_participating_cpu_count();
+        for (size_t i = 1; i < cpuCount; i++) {
+            const size_t victim = (t_cpu + i) % cpuCount;
+
+            const auto stolen = s_deques[victim].steal();
+            if (!stolen.is_error()) {
+                s_statistics[t_cpu].stolen++;
+                return stolen.get_value();
+            }
+        }
+
+        return nullptr;
+    }
+
+    void run_job(u32 t_cpu, Job* t_job) {
+        volatile u32* remaining = t_job->remaining;
+
+        t_job->function(t_job->argument);
+        s_statistics[t_cpu].executed++;
+
+        // The submitter may free the job as soon as it sees the count drop
+        if (remaining != nullptr) {
+            __atomic_sub_fetch(remaining, 1, __ATOMIC_RELEASE);
+        }
+    }
+
+    bool run_one() {
+        const u32 cpu = SMP::get_current_cpu_index();
+
+        Job* job = find_job(cpu);
+        if (job == nullptr) {
+            return false;
+        }
+
+        run_job(cpu, job);
+        return true;
+    }
+
+    void wait_for(volatile u32* t_remaining) {
+        while (__atomic_load_n(t_remaining, __ATOMIC_ACQUIRE) != 0) {
+            if (!run_one()) {
+                asm volatile ("pause");
+            }
+        }
+    }
+
+    struct RangeJob {
+        RangeFunction function;
+        void* context;
+        size_t begin;
+        size_t end;
+    };
+
+    void run_range(void* t_argument) {
+        const RangeJob* range = static_cast<const RangeJob*>(t_argument);
+        range->function(range->begin, range->end, range->context);
+    }
+
+    void parallel_for(size_t t_begin, size_t t_end, size_t t_grainSize, RangeFunction t_function, void* t_context) {
+        if (t_begin >= t_end) {
+            return;
+        }
+
+        const size_t total = t_end - t_begin;
+        const size_t grainSize = (t_grainSize == 0) ? 1 : t_grainSize;
+
+        size_t jobCount = (total + grainSize - 1) / grainSize;
+        if (jobCount > MAX_PARALLEL_FOR_JOBS) {
+            jobCount = MAX_PARALLEL_FOR_JOBS;
+        }
+        const size_t chunkSize = (total + jobCount - 1) / jobCount;
+
+        RangeJob ranges[MAX_PARALLEL_FOR_JOBS];
+        Job jobs[MAX_PARALLEL_FOR_JOBS];
+        volatile u32 remaining = 0;
+
+        for (size_t i = 0; i < jobCount; i++) {
+            const size_t begin = t_begin + i * chunkSize;
+            if (begin >= t_end) {
+                break;
+            }
+            const size_t end = (t_end - begin > chunkSize) ? begin + chunkSize : t_end;
+
+            ranges[i] = RangeJob{ t_function, t_context, begin, end };
+            jobs[i] = Job{ run_range, &ranges[i], &remaining };
+
+            // A full deque just means this CPU does the chunk itself
+            __atomic_add_fetch(&remaining, 1, __ATOMIC_RELAXED);
+            if (push_local(&jobs[i]).is_error()) {
+                run_job(SMP::get_current_cpu_index(), &jobs[i]);
+            }
+        }
+
+        wake_idle_cpus();
+        wait_for(&remaining);
+    }
+
+    void set_active_cpu_count(size_t t_count) {
+        s_workState.activeCPUCount = (t_count == 0) ? 1 : t_count;
+    }
+
+    size_t get_active_cpu_count() {
+        return get_participating_cpu_count();
+    }
+
+    Statistics get_statistics(size_t t_cpu) {
+        if (t_cpu >= SMP::MAX_CPU_COUNT) {
+            return Statistics{ 0, 0 };
+        }
+        return s_statistics[t_cpu];
+    }
+
+    bool has_work(u32 t_cpu) {
+        const size_t cpuCount = get_participating_cpu_count();
+        if (t_cpu >= cpuCount) {
+            return false;
+        }
+
+        for (size_t i = 0; i < cpuCount; i++) {
+            if (!s_deques[i].is_empty()) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void run_idle_loop() {
+        const u32 cpu = SMP::get_current_cpu_index();
+
+        while (true) {
+            if (cpu < get_participating_cpu_count() && run_one()) {
+                continue;
+            }
+
+            disable_interrupts();
+            __atomic_add_fetch(&s_workState.idleCount, 1, __ATOMIC_SEQ_CST);
+
+            if (!has_work(cpu)) {
+                asm volatile ("sti; hlt" : : : "memory"); // sti only takes effect after hlt, so the wake IPI can't be missed
+            }
+
+            __atomic_sub_fetch(&s_workState.idleCount, 1, __ATOMIC_SEQ_CST);
+            enable_interrupts();
+        }
+    }
+
+    void zero_range(size_t t_begin, size_t t_end, void* t_context) {
+        memset(static_cast<u8*>(t_context) + t_begin, 0, t_end - t_begin);
+    }
+
+    void print_scaling_benchmark() {
+        constexpr size_t BUFFER_SIZE = 1024 * 1024;
+        constexpr size_t GRAIN_SIZE = 16 * 1024;
+        constexpr size_t ITERATION_COUNT = 8;
+
+        VGA::put_string("Parallel memset of 1MiB x8\n--------------------------\n");
+
+        u8* buffer = new u8[BUFFER_SIZE];
+        const size_t previousActiveCount = s_workState.activeCPUCount;
+
+        for (size_t cpuCount = 1; cpuCount <= SMP::get_online_cpu_count(); cpuCount++) {
+            set_active_cpu_count(cpuCount);
+
+            const u64 start = read_timestamp_counter();
+            for (size_t i = 0; i < ITERATION_COUNT; i++) {
+                parallel_for(0, BUFFER_SIZE, GRAIN_SIZE, zero_range, buffer);
+            }
+            const u64 cycles = read_timestamp_counter() - start;
+
+            VGA::put_unsigned_decimal(cpuCount);
+            VGA::put_string(" CPU(s): ");
+            VGA::put_unsigned_decimal(static_cast<u32>(cycles / 1000));
+            VGA::put_string(" kcycles\n");
+        }
+
+        set_active_cpu_count(previousActiveCount);
+        delete[] buffer;
+
+        for (size_t cpu = 0; cpu < SMP::get_cpu_count(); cpu++) {
+            VGA::put_string("CPU ");
+            VGA::put_unsigned_decimal(cpu);
+            VGA::put_string(": ");
+            VGA::put_unsigned_decimal(s_statistics[cpu].executed);
+            VGA::put_string(" jobs, ");
+            VGA::put_unsigned_decimal(s_statistics[cpu].stolen);
+            VGA::put_string(" stolen\n");
+        }
+        VGA::new_line();
+    }
+
+    struct QueueStressState {
+        Data::MPMCQueue<u32, 64> queue;
+        u32 poppedCount;
+        u32 poppedSum; // wraps, compared against the wrapped expected sum
+    };
+
+    static QueueStressState s_queueStressState; // static, the cache line aligned queue can't come from kmalloc
+
+    static void take_value(QueueStressState& t_state, u32& r_count, u32& r_sum) {
+        const auto value = t_state.queue.pop();
+        if (!value.is_error()) {
+            r_count++;
+            r_sum += value.get_value();
+        }
+    }
+
+    // Pushes every value in the range, popping one after each push so values cross between CPUs
+    void queue_stress_range(size_t t_begin, size_t t_end, void* t_context) {
+        QueueStressState& state = *static_cast<QueueStressState*>(t_context);
+        u32 count = 0;
+        u32 sum = 0;
+
+        for (size_t i = t_begin; i < t_end; i++) {
+            while (state.queue.push(i + 1).is_error()) {
+                take_value(state, count, sum);
+            }
+            take_value(state, count, sum);
+        }
+
+        __atomic_fetch_add(&state.poppedCount, count, __ATOMIC_RELAXED);
+        __atomic_fetch_add(&state.poppedSum, sum, __ATOMIC_RELAXED);
+    }
+
+    void print_queue_stress_test() {
+        constexpr u32 VALUE_COUNT = 64 * 1024;
+        constexpr size_t GRAIN_SIZE = 1024;
+
+        VGA::put_string("MPMC queue stress, 64K values\n-----------------------------\n");
+
+        QueueStressState* state = &s_queueStressState;
+        const size_t previousActiveCount = s_workState.activeCPUCount;
+
+        for (size_t cpuCount = 1; cpuCount <= SMP::get_online_cpu_count(); cpuCount++) {
+            set_active_cpu_count(cpuCount);
+            state->poppedCount = 0;
+            state->poppedSum = 0;
+
+            const u64 start = read_timestamp_counter();
+            parallel_for(0, VALUE_COUNT, GRAIN_SIZE, queue_stress_range, state);
+            const u64 cycles = read_timestamp_counter() - start;
+
+            // Whatever the last pushes left behind
+            u32 count = 0;
+            u32 sum = 0;
+            while (!state->queue.is_empty()) {
+                take_value(*state, count, sum);
+            }
+            state->poppedCount += count;
+            state->poppedSum += sum;
+
+            const u32 expectedSum = static_cast<u32>((static_cast<u64>(VALUE_COUNT) * (VALUE_COUNT + 1)) / 2);
+            const bool passed = state->poppedCount == VALUE_COUNT && state->poppedSum == expectedSum;
+
+            VGA::put_unsigned_decimal(cpuCount);
+            VGA::put_string(" CPU(s): ");
+            VGA::put_unsigned_decimal(static_cast<u32>(cycles / 1000));
+            VGA::put_string(passed ? " kcycles, ok\n" : " kcycles, FAILED\n");
+        }
+
+        set_active_cpu_count(previousActiveCount);
+        VGA::new_line();
+    }
+
+    void wake_handler(InterruptHandler::InterruptFrame* t_frame) {
+        (void)t_frame;
+        LAPIC::send_end_of_interrupt();
+    }
+
+}
@@ -0,0 +1,67 @@
+#ifndef WORK_INCLUDED
+#define WORK_INCLUDED
+
+#include "common.hpp"
+#include "data/error_or.hpp"
+
+namespace Kernel::Work {
+
+    // Run-to-completion jobs spread over every CPU. Each CPU owns a work-stealing deque: it pushes and pops
+    // its own jobs at the bottom, and idle CPUs steal the oldest jobs from the top of the others'.
+    // Kernel threads stay on the BSP, the application processors only ever run jobs.
+
+    using JobFunction = void (*)(void* t_argument);
+
+    struct Job {
+        JobFunction function = nullptr;
+        void* argument = nullptr;
+        volatile u32* remaining = nullptr; // decremented once the job has run, may be nullptr
+    };
+
+    struct Statistics {
+        u32 executed; // jobs run by the CPU, including stolen ones
+        u32 stolen;
+    };
+
+    using RangeFunction = void (*)(size_t t_begin, size_t t_end, void* t_context);
+
+    constexpr size_t DEQUE_SIZE = 256;
+    constexpr size_t MAX_PARALLEL_FOR_JOBS = 64;
+
+    // Sent to wake halted CPUs when new jobs are pushed
+    constexpr u8 WAKE_VECTOR = 0xF0;
+
+    // Installs the wake IPI handler, call before the application processors are started
+    void initialize();
+
+    // Queues t_job on the calling CPU, t_job must stay valid until it has run
+    Data::ErrorOr<void> submit(Job* t_job);
+
+    // Runs one job from this CPU's deque, or steals one if it's empty. Returns false if there was nothing to run
+    bool run_one();
+
+    // Runs jobs until *t_remaining reaches zero
+    void wait_for(volatile u32* t_remaining);
+
+    // Calls t_function on chunks of [t_begin, t_end) of at least t_grainSize elements, spread over the active CPUs,
+    // and returns once every chunk is done
+    void parallel_for(size_t t_begin, size_t t_end, size_t t_grainSize, RangeFunction t_function, void* t_context);
+
+    // Only CPUs with an index below this run jobs, used to measure scaling. Defaults to every CPU
+    void set_active_cpu_count(size_t t_count);
+    [[nodiscard]] size_t get_active_cpu_count();
+
+    Statistics get_statistics(size_t t_cpu);
+
+    // The application processors' main loop
+    [[noreturn]] void run_idle_loop();
+
+    // Times a parallel memset with 1 to N active CPUs
+    void print_scaling_benchmark();
+
+    // Every active CPU pushes to and pops from one Data::MPMCQueue at once, then checks nothing was lost or duplicated
+    void print_queue_stress_test();
+
+}
+
+#endif
@@ -0,0 +1,43 @@
+#include "completion.hpp"
+#include "drivers/pit/pit.hpp"
+
+namespace Kernel::Sync {
+
+    void Completion::reset() {
+        m_done = false;
+    }
+
+    void Completion::complete() {
+        const u32 flags = save_and_disable_interrupts();
+
+        m_done = true;
+        m_waiters.wake_all();
+
+        restore_interrupts(flags);
+    }
+
+    Data::ErrorOr<void> Completion::wait(uint t_timeoutTicks) {
+        if (!Scheduler::is_initialized()) {
+            const uint start = PIT::get_ticks();
+            while (!m_done) {
+                if (t_timeoutTicks != 0 && PIT::get_ticks() - start >= t_timeoutTicks) {
+                    return Error::TIMED_OUT;
+                }
+                KERNEL_HALT();
+            }
+            return Data::ErrorOr<void>();
+        }
+
+        const u32 flags = save_and_disable_interrupts();
+
+        Data::ErrorOr<void> result;
+        if (!m_done) {
+            result = m_waiters.wait(t_timeoutTicks);
+        }
+
+        restore_interrupts(flags);
+
+        return result;
+    }
+
+}
@@ -0,0 +1,40 @@
+#ifndef SYNC_COMPLETION_INCLUDED
+#define SYNC_COMPLETION_INCLUDED
+
+#include "common.hpp"
+#include "data/error_or.hpp"
+#include "scheduler/wait_queue.hpp"
+
+namespace Kernel::Sync {
+
+    // One-shot event, typically completed by an IRQ handler and waited on by the thread that started the operation
+    class Completion {
+    public:
+        constexpr Completion()
+            : m_done(false)
+            , m_waiters()
+        {
+            ;
+        }
+
+        // Re-arms the completion, call before starting the operation that will complete it
+        void reset();
+
+        // Safe to call from interrupt handlers, wakes every waiter
+        void complete();
+
+        // t_timeoutTicks = 0 waits forever. Before the scheduler is running this falls back to halting until the IRQ
+        Data::ErrorOr<void> wait(uint t_timeoutTicks = 0);
+
+        [[nodiscard]] bool is_done() const {
+            return m_done;
+        }
+
+    private:
+        volatile bool m_done;
+        Scheduler::WaitQueue m_waiters;
+    };
+
+}
+
+#endif
@@ -0,0 +1,64 @@
+#include "lock_statistics.hpp"
+#include "drivers/vga/vga.hpp"
+
+namespace Kernel::Sync {
+
+    static LockStatisticsRecord* s_records = nullptr;
+
+    void LockStatisticsRecord::record_acquire(bool t_contended) {
+        if (!m_registered) {
+            m_registered = true;
+
+            // Prepended without a lock of our own since this is called from inside the locks
+            LockStatisticsRecord* head = __atomic_load_n(&s_records, __ATOMIC_RELAXED);
+            do {
+                m_next = head;
+            } while (!__atomic_compare_exchange_n(&s_records, &head, this, true, __ATOMIC_RELEASE, __ATOMIC_RELAXED));
+        }
+
+        m_statistics.acquisitions++;
+        if (t_contended) {
+            m_statistics.contentions++;
+        }
+        m_acquiredAt = read_timestamp_counter();
+    }
+
+    void LockStatisticsRecord::record_release() {
+        const u32 cycles = static_cast<u32>(read_timestamp_counter() - m_acquiredAt);
+
+        m_statistics.totalHoldCycles += cycles;
+        if (cycles > m_statistics.maxHoldCycles) {
+            m_statistics.maxHoldCycles = cycles;
+        }
+    }
+
+    void print_lock_statistics() {
+        VGA::put_string("Lock Statistics\n---------------\n");
+
+        if constexpr (!LOCK_STATISTICS_ENABLED) {
+            VGA::put_string("Disabled, build with LOCK_STATISTICS=1\n\n");
+            return;
+        }
+
+        for (const LockStatisticsRecord* record = __atomic_load_n(&s_records, __ATOMIC_ACQUIRE); record != nullptr; record = record->m_next) {
+            const LockStatistics statistics = record->get();
+            if (statistics.acquisitions == 0) {
+                continue;
+            }
+
+            VGA::put_string(record->get_name() != nullptr ? record->get_name() : "(unnamed)");
+            VGA::put_string(": ");
+            VGA::put_unsigned_decimal(statistics.acquisitions);
+            VGA::put_string(" taken, ");
+            VGA::put_unsigned_decimal(statistics.contentions);
+            VGA::put_string(" contended, avg hold ");
+            VGA::put_unsigned_decimal(static_cast<u32>(statistics.totalHoldCycles / statistics.acquisitions));
+            VGA::put_string(" max ");
+            VGA::put_unsigned_decimal(statistics.maxHoldCycles);
+            VGA::put_string(" cycles\n");
+        }
+
+        VGA::new_line();
+    }
+
+}
@@ -0,0 +1,79 @@
+#ifndef SYNC_LOCK_STATISTICS_INCLUDED
+#define SYNC_LOCK_STATISTICS_INCLUDED
+
+#include "common.hpp"
+
+// Build with LOCK_STATISTICS=0 to compile the counters out of every lock
+#ifndef KERNEL_LOCK_STATISTICS
+#define KERNEL_LOCK_STATISTICS 0
+#endif
+
+namespace Kernel::Sync {
+
+    constexpr bool LOCK_STATISTICS_ENABLED = (KERNEL_LOCK_STATISTICS != 0);
+
+    struct LockStatistics {
+        u32 acquisitions;
+        u32 contentions; // acquisitions that had to spin or sleep first
+        u64 totalHoldCycles;
+        u32 maxHoldCycles;
+    };
+
+    // Counters embedded in each lock. They are only written by the current holder, so they need no
+    // synchronisation of their own. A lock joins the list printed by print_lock_statistics the first
+    // time it is taken.
+    class LockStatisticsRecord {
+    public:
+        constexpr explicit LockStatisticsRecord(const char* t_name)
+            : m_name(t_name)
+            , m_statistics{ 0, 0, 0, 0 }
+            , m_acquiredAt(0)
+            , m_next(nullptr)
+            , m_registered(false)
+        {
+            ;
+        }
+
+        void on_acquire(bool t_contended) {
+            if constexpr (LOCK_STATISTICS_ENABLED) {
+                record_acquire(t_contended);
+            }
+        }
+
+        void on_release() {
+            if constexpr (LOCK_STATISTICS_ENABLED) {
+                record_release();
+            }
+        }
+
+        [[nodiscard]] LockStatistics get() const {
+            return m_statistics;
+        }
+
+        void reset() {
+            m_statistics = LockStatistics{ 0, 0, 0, 0 };
+        }
+
+        [[nodiscard]] const char* get_name() const {
+            return m_name;
+        }
+
+    private:
+        friend void print_lock_statistics();
+
+        void record_acquire(bool t_contended);
+        void record_release();
+
+        const char* m_name;
+        LockStatistics m_statistics;
+        u64 m_acquiredAt;
+
+        LockStatisticsRecord* m_next;
+        bool m_registered;
+    };
+
+    void print_lock_statistics();
+
+}
+
+#endif
@@ -0,0 +1,67 @@
+#include "mutex.hpp"
+
+#include "drivers/vga/vga.hpp"
+
+namespace Kernel::Sync {
+
+    // Threads only run on the BSP, so masking interrupts is enough to make the check-and-block atomic
+
+    // Locks taken before the scheduler starts have no owner and aren't checked
+    static Scheduler::Thread* get_caller() {
+        return Scheduler::is_initialized() ? Scheduler::get_current_thread() : nullptr;
+    }
+
+    void Mutex::lock() {
+        const u32 flags = save_and_disable_interrupts();
+        Scheduler::Thread* caller = get_caller();
+
+        // It would wait for itself forever
+        if (m_locked && caller != nullptr && m_owner == caller) {
+            VGA::put_string("Mutex locked again by its owner\n");
+            KERNEL_STOP();
+        }
+
+        const bool contended = m_locked;
+        while (m_locked) {
+            (void)m_waiters.wait();
+        }
+
+        m_locked = true;
+        m_owner = caller;
+        m_statistics.on_acquire(contended);
+
+        restore_interrupts(flags);
+    }
+
+    bool Mutex::try_lock() {
+        const u32 flags = save_and_disable_interrupts();
+
+        const bool acquired = !m_locked;
+        if (acquired) {
+            m_locked = true;
+            m_owner = get_caller();
+            m_statistics.on_acquire(false);
+        }
+
+        restore_interrupts(flags);
+
+        return acquired;
+    }
+
+    void Mutex::unlock() {
+        const u32 flags = save_and_disable_interrupts();
+
+        if (!m_locked || (m_owner != nullptr && m_owner != get_caller())) {
+            VGA::put_string("Mutex unlocked by a thread that doesn't hold it\n");
+            KERNEL_STOP();
+        }
+
+        m_statistics.on_release();
+        m_owner = nullptr;
+        m_locked = false;
+        m_waiters.wake_one();
+
+        restore_interrupts(flags);
+    }
+
+}
@@ -0,0 +1,47 @@
+#ifndef SYNC_MUTEX_INCLUDED
+#define SYNC_MUTEX_INCLUDED
+
+#include "common.hpp"
+#include "scheduler/wait_queue.hpp"
+#include "sync/lock_statistics.hpp"
+
+namespace Kernel::Sync {
+
+    // Sleeping lock for kernel threads, waiters block instead of spinning. Must not be used from
+    // interrupt handlers or work jobs, and can't be held across a co_await (see Async::Mutex for that)
+    class Mutex {
+    public:
+        constexpr explicit Mutex(const char* t_name = nullptr)
+            : m_locked(false)
+            , m_owner(nullptr)
+            , m_waiters()
+            , m_statistics(t_name)
+        {
+            ;
+        }
+
+        Mutex(const Mutex&) = delete;
+        Mutex& operator=(const Mutex&) = delete;
+
+        void lock();
+        [[nodiscard]] bool try_lock();
+        void unlock();
+
+        [[nodiscard]] bool is_locked() const {
+            return m_locked;
+        }
+
+        [[nodiscard]] LockStatistics get_statistics() const {
+            return m_statistics.get();
+        }
+
+    private:
+        volatile bool m_locked;
+        Scheduler::Thread* m_owner; // nullptr while unlocked or when locked before the scheduler started
+        Scheduler::WaitQueue m_waiters;
+        LockStatisticsRecord m_statistics;
+    };
+
+}
+
+#endif
@@ -0,0 +1,58 @@
+#include "semaphore.hpp"
+#include "drivers/pit/pit.hpp"
+
+namespace Kernel::Sync {
+
+    Data::ErrorOr<void> Semaphore::wait(uint t_timeoutTicks) {
+        const u32 flags = save_and_disable_interrupts();
+
+        // Another thread can take the count between the wake and this thread running, the timeout covers every
+        // wait together rather than starting over each time
+        const uint start = PIT::get_ticks();
+        while (m_count == 0) {
+            uint remainingTicks = 0;
+            if (t_timeoutTicks != 0) {
+                const uint elapsed = PIT::get_ticks() - start;
+                if (elapsed >= t_timeoutTicks) {
+                    restore_interrupts(flags);
+                    return Error::TIMED_OUT;
+                }
+                remainingTicks = t_timeoutTicks - elapsed;
+            }
+
+            const auto result = m_waiters.wait(remainingTicks);
+            if (result.is_error()) {
+                restore_interrupts(flags);
+                return result;
+            }
+        }
+        m_count = m_count - 1;
+
+        restore_interrupts(flags);
+
+        return Data::ErrorOr<void>();
+    }
+
+    bool Semaphore::try_wait() {
+        const u32 flags = save_and_disable_interrupts();
+
+        const bool acquired = (m_count != 0);
+        if (acquired) {
+            m_count = m_count - 1;
+        }
+
+        restore_interrupts(flags);
+
+        return acquired;
+    }
+
+    void Semaphore::signal() {
+        const u32 flags = save_and_disable_interrupts();
+
+        m_count = m_count + 1;
+        m_waiters.wake_one();
+
+        restore_interrupts(flags);
+    }
+
+}
@@ -0,0 +1,37 @@
+#ifndef SYNC_SEMAPHORE_INCLUDED
+#define SYNC_SEMAPHORE_INCLUDED
+
+#include "common.hpp"
+#include "data/error_or.hpp"
+#include "scheduler/wait_queue.hpp"
+
+namespace Kernel::Sync {
+
+    class Semaphore {
+    public:
+        constexpr explicit Semaphore(u32 t_count = 0)
+            : m_count(t_count)
+            , m_waiters()
+        {
+            ;
+        }
+
+        // Blocks until the count is non-zero then decrements it. t_timeoutTicks = 0 waits forever
+        Data::ErrorOr<void> wait(uint t_timeoutTicks = 0);
+        [[nodiscard]] bool try_wait();
+
+        // Safe to call from interrupt handlers
+        void signal();
+
+        [[nodiscard]] u32 get_count() const {
+            return m_count;
+        }
+
+    private:
+        volatile u32 m_count;
+        Scheduler::WaitQueue m_waiters;
+    };
+
+}
+
+#endif
@@ -0,0 +1,34 @@
+#include "spinlock.hpp"
+
+namespace Kernel::Sync {
+
+    void SpinLock::lock() {
+        const u32 ticket = __atomic_fetch_add(&m_nextTicket, 1, __ATOMIC_RELAXED);
+
+        bool contended = false;
+        while (__atomic_load_n(&m_nowServing, __ATOMIC_ACQUIRE) != ticket) {
+            contended = true;
+            asm volatile ("pause");
+        }
+
+        m_statistics.on_acquire(contended);
+    }
+
+    bool SpinLock::try_lock() {
+        u32 ticket = __atomic_load_n(&m_nowServing, __ATOMIC_RELAXED);
+        if (!__atomic_compare_exchange_n(&m_nextTicket, &ticket, ticket + 1, false, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)) {
+            return false;
+        }
+
+        m_statistics.on_acquire(false);
+        return true;
+    }
+
+    void SpinLock::unlock() {
+        m_statistics.on_release();
+
+        // Only the holder writes m_nowServing
+        __atomic_store_n(&m_nowServing, m_nowServing + 1, __ATOMIC_RELEASE);
+    }
+
+}
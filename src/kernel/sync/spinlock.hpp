@@ -0,0 +1,98 @@
+#ifndef SYNC_SPINLOCK_INCLUDED
+#define SYNC_SPINLOCK_INCLUDED
+
+#include "common.hpp"
+#include "sync/lock_statistics.hpp"
+
+namespace Kernel::Sync {
+
+    // Ticket lock, CPUs get the lock in the order they asked for it. Never take one that an interrupt
+    // handler also takes, use IRQSpinLock for that
+    class SpinLock {
+    public:
+        constexpr explicit SpinLock(const char* t_name = nullptr)
+            : m_nextTicket(0)
+            , m_nowServing(0)
+            , m_statistics(t_name)
+        {
+            ;
+        }
+
+        SpinLock(const SpinLock&) = delete;
+        SpinLock& operator=(const SpinLock&) = delete;
+
+        void lock();
+        [[nodiscard]] bool try_lock();
+        void unlock();
+
+        [[nodiscard]] bool is_locked() const {
+            return __atomic_load_n(&m_nextTicket, __ATOMIC_RELAXED) != __atomic_load_n(&m_nowServing, __ATOMIC_RELAXED);
+        }
+
+        [[nodiscard]] LockStatistics get_statistics() const {
+            return m_statistics.get();
+        }
+
+    private:
+        u32 m_nextTicket;
+        u32 m_nowServing;
+        LockStatisticsRecord m_statistics;
+    };
+
+    // Spin lock that also disables interrupts on the local CPU while held, for state shared with IRQ handlers
+    class IRQSpinLock {
+    public:
+        constexpr explicit IRQSpinLock(const char* t_name = nullptr)
+            : m_lock(t_name)
+            , m_savedFlags(0)
+        {
+            ;
+        }
+
+        void lock() {
+            const u32 flags = save_and_disable_interrupts();
+            m_lock.lock();
+            m_savedFlags = flags;
+        }
+
+        void unlock() {
+            const u32 flags = m_savedFlags;
+            m_lock.unlock();
+            restore_interrupts(flags);
+        }
+
+        [[nodiscard]] bool is_locked() const {
+            return m_lock.is_locked();
+        }
+
+        [[nodiscard]] LockStatistics get_statistics() const {
+            return m_lock.get_statistics();
+        }
+
+    private:
+        SpinLock m_lock;
+        u32 m_savedFlags; // only touched by the holder
+    };
+
+    // Holds a SpinLock, IRQSpinLock or Mutex for the rest of the scope
+    template <typename T>
+    class LockGuard {
+    public:
+        explicit LockGuard(T& t_lock) : m_lock(t_lock) {
+            m_lock.lock();
+        }
+
+        ~LockGuard() {
+            m_lock.unlock();
+        }
+
+        LockGuard(const LockGuard&) = delete;
+        LockGuard& operator=(const LockGuard&) = delete;
+
+    private:
+        T& m_lock;
+    };
+
+}
+
+#endif
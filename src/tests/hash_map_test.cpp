@@ -0,0 +1,255 @@
+// Randomised test of Data::HashMap against a plain array, and the lookup benchmark of the kernel's F6 command
+// against a linear scan, both repeatable from a fixed seed
+
+#include "data/hash_map.hpp"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+using namespace Kernel;
+
+namespace {
+
+    struct HostAllocator {
+        static Data::ErrorOr<void*> allocate(size_t t_size) {
+            void* memory = malloc(t_size);
+            if (memory == nullptr) {
+                return Error::MEMORY_MANAGER_NO_FREE_BLOCKS;
+            }
+            return memory;
+        }
+
+        static void deallocate(void* t_memory) {
+            free(t_memory);
+        }
+    };
+
+    // xorshift32, the same sequence on every run
+    struct Random {
+        u32 state;
+
+        u32 next() {
+            state ^= state << 13;
+            state ^= state >> 17;
+            state ^= state << 5;
+            return state;
+        }
+    };
+
+    u64 get_nanoseconds() {
+        timespec time;
+        clock_gettime(CLOCK_MONOTONIC, &time);
+        return static_cast<u64>(time.tv_sec) * 1000000000 + time.tv_nsec;
+    }
+
+    // Owns heap memory so moves that lose or duplicate a value show up as leaks or double frees under SANITIZE=1
+    class OwnedValue {
+    public:
+        explicit OwnedValue(u32 t_value)
+            : m_value(static_cast<u32*>(malloc(sizeof(u32))))
+        {
+            *m_value = t_value;
+        }
+
+        OwnedValue(OwnedValue&& t_other)
+            : m_value(t_other.m_value)
+        {
+            t_other.m_value = nullptr;
+        }
+
+        OwnedValue& operator=(OwnedValue&& t_other) {
+            free(m_value);
+            m_value = t_other.m_value;
+            t_other.m_value = nullptr;
+            return *this;
+        }
+
+        OwnedValue(const OwnedValue&) = delete;
+        OwnedValue& operator=(const OwnedValue&) = delete;
+
+        ~OwnedValue() {
+            free(m_value);
+        }
+
+        u32 get() const {
+            return *m_value;
+        }
+
+    private:
+        u32* m_value;
+    };
+
+    bool fail(const char* t_reason, u32 t_operation) {
+        printf("  %s after %u operations\n", t_reason, t_operation);
+        return false;
+    }
+
+    // Random sets, removes and lookups over a small key space, so keys come and go many times and the table
+    // grows, wraps around and shifts entries back on removal. Every step is checked against a plain array
+    bool run_random_test(u32 t_seed) {
+        constexpr u32 KEY_COUNT = 3000;
+        constexpr u32 OPERATION_COUNT = 400000;
+
+        static bool present[KEY_COUNT];
+        static u32 expected[KEY_COUNT];
+        for (u32 key = 0; key < KEY_COUNT; key++) {
+            present[key] = false;
+        }
+        size_t expectedSize = 0;
+
+        Data::HashMap<u64, OwnedValue, Data::HashTraits<u64>, HostAllocator> map;
+        Random random { t_seed };
+
+        for (u32 operation = 0; operation < OPERATION_COUNT; operation++) {
+            // Spread the keys out so they don't land in consecutive home slots
+            const u32 index = random.next() % KEY_COUNT;
+            const u64 key = static_cast<u64>(index) * 0x9E3779B1;
+
+            switch (random.next() % 3) {
+                case 0:
+                    if (map.set(key, OwnedValue(operation)).is_error()) {
+                        return fail("set failed", operation);
+                    }
+                    if (!present[index]) {
+                        present[index] = true;
+                        expectedSize++;
+                    }
+                    expected[index] = operation;
+                    break;
+                case 1: {
+                    const bool removed = !map.remove(key).is_error();
+                    if (removed != present[index]) {
+                        return fail("remove disagrees with the reference", operation);
+                    }
+                    if (present[index]) {
+                        present[index] = false;
+                        expectedSize--;
+                    }
+                    break;
+                }
+                default: {
+                    const OwnedValue* value = map.find(key);
+                    if ((value != nullptr) != present[index] || (value != nullptr && value->get() != expected[index])) {
+                        return fail("find disagrees with the reference", operation);
+                    }
+                    break;
+                }
+            }
+
+            if (map.size() != expectedSize) {
+                return fail("size disagrees with the reference", operation);
+            }
+        }
+
+        size_t iterated = 0;
+        for (auto& entry : map) {
+            const u32 index = static_cast<u32>(entry.key / 0x9E3779B1);
+            if (index >= KEY_COUNT || !present[index] || entry.value.get() != expected[index]) {
+                return fail("iteration returned an entry the reference doesn't have", OPERATION_COUNT);
+            }
+            iterated++;
+        }
+        if (iterated != expectedSize) {
+            return fail("iteration missed entries", OPERATION_COUNT);
+        }
+
+        // Moving hands every entry over and leaves the source empty
+        Data::HashMap<u64, OwnedValue, Data::HashTraits<u64>, HostAllocator> moved(Data::move(map));
+        if (moved.size() != expectedSize || map.size() != 0) {
+            return fail("move lost entries", OPERATION_COUNT);
+        }
+
+        printf("seed %u: %u operations, %zu entries left, capacity %zu, ok\n", t_seed, OPERATION_COUNT, expectedSize, moved.capacity());
+        return true;
+    }
+
+    bool run_string_test() {
+        Data::HashMap<const char*, u32, Data::StringHashTraits, HostAllocator> map;
+        (void)map.set("hello", 1);
+        (void)map.set("world", 2);
+
+        // Looked up by contents, not by address
+        char hello[] = "hello";
+        const u32* value = map.find(hello);
+        const bool passed = value != nullptr && *value == 1 && !map.contains("nope");
+
+        printf("string keys: %s\n", passed ? "ok" : "FAILED");
+        return passed;
+    }
+
+    struct KeyValue {
+        u32 key;
+        u32 value;
+    };
+
+    // The baseline that a table without a map ends up with
+    const u32* linear_find(const KeyValue* t_entries, size_t t_count, u32 t_key) {
+        for (size_t i = 0; i < t_count; i++) {
+            if (t_entries[i].key == t_key) {
+                return &t_entries[i].value;
+            }
+        }
+        return nullptr;
+    }
+
+    // Same workload as the kernel's F6 command: lookups of keys, half of them present
+    bool run_benchmark() {
+        constexpr size_t MAX_ENTRY_COUNT = 4096;
+        constexpr size_t LOOKUP_COUNT = 64 * 1024;
+
+        static KeyValue entries[MAX_ENTRY_COUNT];
+        bool passed = true;
+
+        for (size_t count = 16; count <= MAX_ENTRY_COUNT; count *= 4) {
+            Data::HashMap<u32, u32, Data::HashTraits<u32>, HostAllocator> map;
+            if (map.reserve(count).is_error()) {
+                printf("Out of memory\n");
+                return false;
+            }
+
+            // Even keys are stored, odd ones are the misses
+            for (size_t i = 0; i < count; i++) {
+                entries[i] = KeyValue { Data::hash_integer(i) & ~1u, static_cast<u32>(i) };
+                (void)map.set(entries[i].key, entries[i].value);
+            }
+
+            u32 linearFound = 0;
+            const u64 linearStart = get_nanoseconds();
+            for (size_t i = 0; i < LOOKUP_COUNT; i++) {
+                const u32 key = entries[i % count].key | (i & 1);
+                linearFound += (linear_find(entries, count, key) != nullptr);
+            }
+            const u64 linearNanoseconds = get_nanoseconds() - linearStart;
+
+            u32 mapFound = 0;
+            const u64 mapStart = get_nanoseconds();
+            for (size_t i = 0; i < LOOKUP_COUNT; i++) {
+                const u32 key = entries[i % count].key | (i & 1);
+                mapFound += (map.find(key) != nullptr);
+            }
+            const u64 mapNanoseconds = get_nanoseconds() - mapStart;
+
+            printf("%zu entries: linear %llu ns, map %llu ns per lookup%s\n", count,
+                static_cast<unsigned long long>(linearNanoseconds / LOOKUP_COUNT), static_cast<unsigned long long>(mapNanoseconds / LOOKUP_COUNT),
+                linearFound == mapFound ? "" : ", MISMATCH");
+            passed &= (linearFound == mapFound);
+        }
+
+        return passed;
+    }
+
+}
+
+int main() {
+    bool passed = true;
+
+    constexpr u32 SEEDS[] = { 1, 0xC0FFEE, 0xDEADBEEF };
+    for (const u32 seed : SEEDS) {
+        passed &= run_random_test(seed);
+    }
+    passed &= run_string_test();
+    passed &= run_benchmark();
+
+    return passed ? 0 : 1;
+}
@@ -0,0 +1,248 @@
+// Stress test and throughput benchmark of Data::MPMCQueue on host threads. The kernel's F5 command runs the
+// mixed workload on however many CPUs the machine has, this runs it repeatably and checks every value on top
+
+#include "data/mpmc_queue.hpp"
+
+#include <pthread.h>
+#include <stdio.h>
+#include <time.h>
+
+using namespace Kernel;
+
+namespace {
+
+    constexpr size_t QUEUE_SIZE = 64;
+    constexpr size_t MAX_THREAD_COUNT = 8;
+    constexpr u32 VALUES_PER_PRODUCER = 256 * 1024;
+
+    using Queue = Data::MPMCQueue<u32, QUEUE_SIZE>;
+
+    // The producer goes in the top byte and its running number below, so a consumer can check that one producer's
+    // values come out in the order they went in
+    constexpr u32 make_value(u32 t_producer, u32 t_index) {
+        return (t_producer << 24) | (t_index + 1);
+    }
+
+    struct StressState {
+        Queue queue;
+        u32 producerCount;
+        u32 totalCount;
+        u32 poppedCount;
+        u32 failureCount;
+        u8 seen[MAX_THREAD_COUNT][VALUES_PER_PRODUCER + 1];
+    };
+
+    struct ThreadArgument {
+        StressState* state;
+        u32 index;
+    };
+
+    StressState s_stressState; // static, the cache line aligned queue and the seen table are too big for a stack
+
+    u64 get_nanoseconds() {
+        timespec time;
+        clock_gettime(CLOCK_MONOTONIC, &time);
+        return static_cast<u64>(time.tv_sec) * 1000000000 + time.tv_nsec;
+    }
+
+    // Called when the queue was full or empty. Spins a little first, then sleeps so the other side gets to run even
+    // when there are fewer CPUs than threads
+    void back_off(u32& r_attempts) {
+        constexpr u32 SPIN_COUNT = 64;
+
+        if (++r_attempts < SPIN_COUNT) {
+            __builtin_ia32_pause();
+            return;
+        }
+
+        r_attempts = 0;
+        const timespec duration = { 0, 1000 };
+        nanosleep(&duration, nullptr);
+    }
+
+    void record_failure(StressState& t_state, const char* t_reason) {
+        if (__atomic_fetch_add(&t_state.failureCount, 1, __ATOMIC_RELAXED) == 0) {
+            printf("  %s\n", t_reason);
+        }
+    }
+
+    void* produce(void* t_argument) {
+        const ThreadArgument& argument = *static_cast<ThreadArgument*>(t_argument);
+
+        u32 attempts = 0;
+        for (u32 i = 0; i < VALUES_PER_PRODUCER; i++) {
+            while (argument.state->queue.push(make_value(argument.index, i)).is_error()) {
+                back_off(attempts);
+            }
+        }
+
+        return nullptr;
+    }
+
+    void* consume(void* t_argument) {
+        StressState& state = *static_cast<ThreadArgument*>(t_argument)->state;
+        u32 lastIndex[MAX_THREAD_COUNT] = {};
+        u32 attempts = 0;
+
+        while (__atomic_load_n(&state.poppedCount, __ATOMIC_RELAXED) < state.totalCount) {
+            const auto value = state.queue.pop();
+            if (value.is_error()) {
+                back_off(attempts);
+                continue;
+            }
+            __atomic_fetch_add(&state.poppedCount, 1, __ATOMIC_RELAXED);
+
+            const u32 producer = value.get_value() >> 24;
+            const u32 index = value.get_value() & 0xFFFFFF;
+            if (producer >= state.producerCount || index == 0 || index > VALUES_PER_PRODUCER) {
+                record_failure(state, "popped a value that was never pushed");
+                continue;
+            }
+            if (index <= lastIndex[producer]) {
+                record_failure(state, "a producer's values came out of order");
+            }
+            lastIndex[producer] = index;
+
+            if (__atomic_fetch_add(&state.seen[producer][index], 1, __ATOMIC_RELAXED) != 0) {
+                record_failure(state, "popped a value twice");
+            }
+        }
+
+        return nullptr;
+    }
+
+    // Dedicated producers and consumers, every value is checked to come out exactly once and in order per producer
+    bool run_stress(u32 t_producerCount, u32 t_consumerCount) {
+        StressState& state = s_stressState;
+        state.producerCount = t_producerCount;
+        state.totalCount = t_producerCount * VALUES_PER_PRODUCER;
+        state.poppedCount = 0;
+        state.failureCount = 0;
+        for (size_t producer = 0; producer < MAX_THREAD_COUNT; producer++) {
+            for (size_t i = 0; i <= VALUES_PER_PRODUCER; i++) {
+                state.seen[producer][i] = 0;
+            }
+        }
+
+        pthread_t threads[2 * MAX_THREAD_COUNT];
+        ThreadArgument arguments[2 * MAX_THREAD_COUNT];
+        const u32 threadCount = t_producerCount + t_consumerCount;
+
+        const u64 start = get_nanoseconds();
+        for (u32 i = 0; i < threadCount; i++) {
+            const bool producer = (i < t_producerCount);
+            arguments[i] = ThreadArgument { &state, producer ? i : i - t_producerCount };
+            pthread_create(&threads[i], nullptr, producer ? produce : consume, &arguments[i]);
+        }
+        for (u32 i = 0; i < threadCount; i++) {
+            pthread_join(threads[i], nullptr);
+        }
+        const u64 nanoseconds = get_nanoseconds() - start;
+
+        for (u32 producer = 0; producer < t_producerCount; producer++) {
+            for (u32 i = 1; i <= VALUES_PER_PRODUCER; i++) {
+                if (state.seen[producer][i] != 1) {
+                    record_failure(state, "a value was lost");
+                    break;
+                }
+            }
+        }
+        if (!state.queue.is_empty()) {
+            record_failure(state, "the queue isn't empty at the end");
+        }
+
+        printf("%u producer(s), %u consumer(s): %llu ns per value, %s\n", t_producerCount, t_consumerCount,
+            static_cast<unsigned long long>(nanoseconds / state.totalCount), state.failureCount == 0 ? "ok" : "FAILED");
+
+        return state.failureCount == 0;
+    }
+
+    struct MixedState {
+        Queue queue;
+        u32 poppedCount;
+        u32 poppedSum; // wraps, compared against the wrapped expected sum
+    };
+
+    MixedState s_mixedState;
+
+    void take_value(MixedState& t_state, u32& r_count, u32& r_sum) {
+        const auto value = t_state.queue.pop();
+        if (!value.is_error()) {
+            r_count++;
+            r_sum += value.get_value();
+        }
+    }
+
+    // The kernel's F5 workload: every thread pushes its range, popping one after each push so values cross threads
+    void* push_and_pop(void* t_argument) {
+        const ThreadArgument& argument = *static_cast<ThreadArgument*>(t_argument);
+        MixedState& state = s_mixedState;
+        u32 count = 0;
+        u32 sum = 0;
+
+        for (u32 i = argument.index * VALUES_PER_PRODUCER; i < (argument.index + 1) * VALUES_PER_PRODUCER; i++) {
+            while (state.queue.push(i + 1).is_error()) {
+                take_value(state, count, sum);
+            }
+            take_value(state, count, sum);
+        }
+
+        __atomic_fetch_add(&state.poppedCount, count, __ATOMIC_RELAXED);
+        __atomic_fetch_add(&state.poppedSum, sum, __ATOMIC_RELAXED);
+
+        return nullptr;
+    }
+
+    bool run_mixed(u32 t_threadCount) {
+        MixedState& state = s_mixedState;
+        state.poppedCount = 0;
+        state.poppedSum = 0;
+
+        pthread_t threads[MAX_THREAD_COUNT];
+        ThreadArgument arguments[MAX_THREAD_COUNT];
+
+        const u64 start = get_nanoseconds();
+        for (u32 i = 0; i < t_threadCount; i++) {
+            arguments[i] = ThreadArgument { nullptr, i };
+            pthread_create(&threads[i], nullptr, push_and_pop, &arguments[i]);
+        }
+        for (u32 i = 0; i < t_threadCount; i++) {
+            pthread_join(threads[i], nullptr);
+        }
+        const u64 nanoseconds = get_nanoseconds() - start;
+
+        // Whatever the last pushes left behind
+        u32 count = 0;
+        u32 sum = 0;
+        while (!state.queue.is_empty()) {
+            take_value(state, count, sum);
+        }
+        state.poppedCount += count;
+        state.poppedSum += sum;
+
+        const u32 valueCount = t_threadCount * VALUES_PER_PRODUCER;
+        const u32 expectedSum = static_cast<u32>((static_cast<u64>(valueCount) * (valueCount + 1)) / 2);
+        const bool passed = state.poppedCount == valueCount && state.poppedSum == expectedSum;
+
+        printf("%u thread(s) pushing and popping: %llu ns per value, %s\n", t_threadCount,
+            static_cast<unsigned long long>(nanoseconds / valueCount), passed ? "ok" : "FAILED");
+
+        return passed;
+    }
+
+}
+
+int main() {
+    bool passed = true;
+
+    constexpr u32 STRESS_SHAPES[][2] = { {1, 1}, {2, 2}, {4, 4}, {1, 4}, {4, 1}, {8, 8} };
+    for (const auto& shape : STRESS_SHAPES) {
+        passed &= run_stress(shape[0], shape[1]);
+    }
+
+    for (u32 threadCount = 1; threadCount <= MAX_THREAD_COUNT; threadCount *= 2) {
+        passed &= run_mixed(threadCount);
+    }
+
+    return passed ? 0 : 1;
+}
@@ -1,3 +1,3 @@
 #!/usr/bin/env bash
 
-qemu-system-i386 -machine q35 -drive file=./build/bootdisk.img,format=raw,index=0,if=floppy
+qemu-system-i386 -machine q35 -drive file=./build/bootdisk.img,format=raw,index=0,if=floppy -smp 4